@@ -0,0 +1,281 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file asyncpricer.hpp
+    \brief deadline-bounded, cancellable pricing on the const engines
+*/
+
+#ifndef quantlib_async_pricer_hpp
+#define quantlib_async_pricer_hpp
+
+#include <ql/instrument.hpp>
+#include <ql/utilities/null.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/future.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <string>
+
+namespace QuantLib {
+
+    //! estimate reached by a bounded pricing
+    struct AsyncPricingResult {
+        enum Status { Running, Converged, MaxSamplesReached,
+                      DeadlineReached, Cancelled, Failed };
+
+        AsyncPricingResult()
+        : value(Null<Real>()), errorEstimate(Null<Real>()), samples(0),
+          status(Running) {}
+
+        Real value, errorEstimate;
+        Size samples;
+        Status status;
+        std::string message;
+    };
+
+    //! running estimate and cancellation token of one pricing
+    /*! Shared between the caller and the pricing thread; all members
+        can be called from either side. */
+    class PricingMonitor : private boost::noncopyable {
+      public:
+        PricingMonitor() : cancelled_(false) {}
+
+        void cancel() {
+            boost::mutex::scoped_lock lock(mutex_);
+            cancelled_ = true;
+        }
+        bool cancelled() const {
+            boost::mutex::scoped_lock lock(mutex_);
+            return cancelled_;
+        }
+        //! latest estimate; status is Running until the pricing ends
+        AsyncPricingResult current() const {
+            boost::mutex::scoped_lock lock(mutex_);
+            return current_;
+        }
+        void publish(const AsyncPricingResult& result) {
+            boost::mutex::scoped_lock lock(mutex_);
+            current_ = result;
+        }
+
+      private:
+        mutable boost::mutex mutex_;
+        bool cancelled_;
+        AsyncPricingResult current_;
+    };
+
+
+    //! prices in growing batches until done, late or cancelled
+    /*! The engine is asked for firstBatch samples, then for up to
+        twice as many at each step through setRequiredSamples(); on
+        frozen parameters the const engines top up their Monte Carlo
+        model, so only the new paths are simulated and every step adds
+        to the same estimate. A step never adds more paths than fit in
+        one time slice, judged from the time per simulated path so
+        far, which bounds the delay of a cancellation. Between steps
+        the estimate is published to the monitor, and the pricing stops
+        when maxSamples or the tolerance is reached, when the monitor
+        is cancelled, or when the next step would pass the deadline;
+        the last step is shrunk to what still fits. With a deadline the
+        first step is a probe of at most probeSamples paths, which
+        gives the time per path before any larger step is sized; a
+        deadline already passed returns at once with no estimate. The
+        result is the best estimate reached.
+
+        Engines that cannot top up (no frozen parameters, local-vol
+        grid, stratified sampling) simulate all the samples of a step
+        again; the engine reports it through lastRunToppedUp() and the
+        step is then budgeted at its full size against the deadline.
+        For them the slice cannot bound a step, which always costs at
+        least the previous one, so a cancellation waits for the
+        running step.
+
+        Engine is MCEuropeanConstEngine or
+        MCDiscreteArithmeticAPConstEngine. The engine is driven
+        directly on the instrument's arguments, as Instrument does,
+        and the instrument keeps its own engine. QuantLib objects are
+        not thread-safe: while an asynchronous pricing runs, the
+        instrument, the engine and the market they observe must not be
+        used or changed by other threads.
+    */
+    template <class Engine>
+    class DeadlinePricer {
+      public:
+        enum { probeSamples = 64 };
+
+        DeadlinePricer(const boost::shared_ptr<Instrument>& instrument,
+                       const boost::shared_ptr<Engine>& engine,
+                       Size maxSamples,
+                       Real tolerance = Null<Real>(),
+                       Size firstBatch = 1024,
+                       const boost::posix_time::time_duration& slice =
+                                    boost::posix_time::milliseconds(10))
+        : instrument_(instrument), engine_(engine),
+          maxSamples_(maxSamples), tolerance_(tolerance),
+          firstBatch_(std::min(firstBatch, maxSamples)), slice_(slice) {
+            QL_REQUIRE(instrument_, "no instrument given");
+            QL_REQUIRE(engine_, "no engine given");
+            QL_REQUIRE(firstBatch_ > 1, "too few samples in the first batch");
+        }
+
+        //! prices in the calling thread
+        /*! A not_a_date_time deadline means no deadline; deadlines are
+            in universal time. */
+        AsyncPricingResult operator()(
+                const boost::shared_ptr<PricingMonitor>& monitor,
+                const boost::posix_time::ptime& deadline =
+                                      boost::posix_time::ptime()) const {
+            using namespace boost::posix_time;
+            AsyncPricingResult result;
+            try {
+                ptime started = microsec_clock::universal_time();
+                if (!deadline.is_not_a_date_time() && started >= deadline) {
+                    result.status = AsyncPricingResult::DeadlineReached;
+                    result.message = "deadline already passed";
+                    if (monitor)
+                        monitor->publish(result);
+                    return result;
+                }
+                // with a deadline, time a small probe before sizing steps
+                Size next = deadline.is_not_a_date_time() ?
+                    firstBatch_ :
+                    std::min<Size>(firstBatch_, probeSamples);
+                // paths actually simulated, and whether the last step
+                // only added to the previous ones
+                Size simulated = 0;
+                bool toppingUp = false;
+                for (;;) {
+                    if (monitor && monitor->cancelled()) {
+                        result.status = AsyncPricingResult::Cancelled;
+                        break;
+                    }
+                    ptime now = microsec_clock::universal_time();
+                    if (!deadline.is_not_a_date_time() && now >= deadline) {
+                        result.status = AsyncPricingResult::DeadlineReached;
+                        break;
+                    }
+                    if (simulated > 0) {
+                        double perSample =
+                            std::max<double>(
+                                (now-started).total_microseconds(), 1.0)
+                            / double(simulated);
+                        // paths a step may simulate: one time slice...
+                        Size budget = std::max<Size>(
+                            Size(slice_.total_microseconds()/perSample), 1);
+                        if (toppingUp)
+                            next = std::min(next, result.samples + budget);
+                        // ...and what is left before the deadline
+                        if (!deadline.is_not_a_date_time()) {
+                            Size affordable = Size(
+                                0.9*(deadline-now).total_microseconds()
+                                / perSample);
+                            Size fits = toppingUp ?
+                                result.samples + affordable : affordable;
+                            if (fits <= result.samples) {
+                                result.status =
+                                    AsyncPricingResult::DeadlineReached;
+                                break;
+                            }
+                            next = std::min(next, fits);
+                        }
+                    }
+
+                    engine_->setRequiredSamples(next);
+                    // as Instrument::performCalculations, without binding
+                    // the engine to the caller's instrument
+                    engine_->reset();
+                    instrument_->setupArguments(engine_->getArguments());
+                    engine_->getArguments()->validate();
+                    engine_->calculate();
+                    const Instrument::results* r =
+                        dynamic_cast<const Instrument::results*>(
+                                                   engine_->getResults());
+                    QL_REQUIRE(r, "engine gave no instrument results");
+                    result.value = r->value;
+                    result.errorEstimate = r->errorEstimate;
+                    toppingUp = engine_->lastRunToppedUp();
+                    simulated += toppingUp ? next - result.samples : next;
+                    result.samples = next;
+                    if (monitor)
+                        monitor->publish(result);
+
+                    if (tolerance_ != Null<Real>() &&
+                        result.errorEstimate != Null<Real>() &&
+                        result.errorEstimate <= tolerance_) {
+                        result.status = AsyncPricingResult::Converged;
+                        break;
+                    }
+                    if (result.samples >= maxSamples_) {
+                        result.status = tolerance_ == Null<Real>() ?
+                            AsyncPricingResult::Converged :
+                            AsyncPricingResult::MaxSamplesReached;
+                        break;
+                    }
+                    next = std::min(std::max(2*result.samples, firstBatch_),
+                                    maxSamples_);
+                }
+            } catch (std::exception& e) {
+                result.status = AsyncPricingResult::Failed;
+                result.message = e.what();
+            } catch (...) {
+                result.status = AsyncPricingResult::Failed;
+                result.message = "unknown error";
+            }
+            if (monitor)
+                monitor->publish(result);
+            return result;
+        }
+
+        //! prices in a new thread; the future holds the final result
+        boost::shared_future<AsyncPricingResult> async(
+                const boost::shared_ptr<PricingMonitor>& monitor,
+                const boost::posix_time::ptime& deadline =
+                                      boost::posix_time::ptime()) const {
+            boost::shared_ptr<boost::promise<AsyncPricingResult> > promise(
+                              new boost::promise<AsyncPricingResult>);
+            boost::shared_future<AsyncPricingResult> future(
+                                                   promise->get_future());
+            boost::thread worker(Task(*this, monitor, deadline, promise));
+            worker.detach();
+            return future;
+        }
+
+      private:
+        struct Task {
+            Task(const DeadlinePricer& pricer,
+                 const boost::shared_ptr<PricingMonitor>& monitor,
+                 const boost::posix_time::ptime& deadline,
+                 const boost::shared_ptr<
+                     boost::promise<AsyncPricingResult> >& promise)
+            : pricer(pricer), monitor(monitor), deadline(deadline),
+              promise(promise) {}
+            void operator()() const {
+                promise->set_value(pricer(monitor, deadline));
+            }
+            DeadlinePricer pricer;
+            boost::shared_ptr<PricingMonitor> monitor;
+            boost::posix_time::ptime deadline;
+            boost::shared_ptr<boost::promise<AsyncPricingResult> > promise;
+        };
+
+        boost::shared_ptr<Instrument> instrument_;
+        boost::shared_ptr<Engine> engine_;
+        Size maxSamples_;
+        Real tolerance_;
+        Size firstBatch_;
+        boost::posix_time::time_duration slice_;
+    };
+
+}
+
+
+#endif
@@ -0,0 +1,472 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*  Streaming batch pricer for the const engines.
+
+    Usage: batchpricer [options] input [output]
+
+    Trades are read one at a time from input ("-" for stdin) and one
+    result line "id,npv,error,ms,status,message" is written per trade
+    to output (stdout by default), so memory does not depend on the
+    size of the book. status is "ok" or "failed"; a trade that fails to
+    price gives "id,,,,failed,message" and the run goes on. The message
+    is always quoted, with embedded quotes doubled.
+
+    CSV input, one trade per line (blank lines and '#' comments are
+    skipped, as is a first line made of exactly these column names):
+
+        id,product,type,spot,strike,r,q,vol,maturity,fixings
+
+    product is European or Asian, type is Call or Put, maturity is an
+    ISO date (yyyy-mm-dd) and fixings is the number of equally spaced
+    fixing dates of an Asian trade, a positive integer (ignored for
+    Europeans). Rates and
+    volatility are flat. A number that does not parse in full gives a
+    failed row instead of being read as 0.
+
+    Binary input (selected by --binary or a .bin extension) is a
+    sequence of BinaryTrade records in native byte order; unknown
+    product or type codes fail the trade.
+
+    Options:
+        --samples n          samples per trade (default 32768)
+        --tolerance x        absolute tolerance instead of samples
+        --steps n            time steps for Europeans (default 1)
+        --seed n             RNG seed (default 42)
+        --sobol              low-discrepancy sequences (needs --samples)
+        --noconst            use the term structures at every step
+        --binary             force binary input
+        --date yyyy-mm-dd    evaluation date (default today)
+*/
+
+#include <ql/quantlib.hpp>
+#include "./blackscholesconstprocess.hpp"
+#include "./mceuropeanconstengine.hpp"
+#include "./mc_discr_arith_av_price_const.hpp"
+#include <boost/cstdint.hpp>
+#include <fstream>
+#include <sstream>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+using namespace QuantLib;
+
+namespace {
+
+    // fixed-size record of the binary trade format
+    struct BinaryTrade {
+        boost::uint64_t id;
+        boost::uint32_t product;      // 0 = European, 1 = Asian
+        boost::uint32_t type;         // 0 = Call, 1 = Put
+        double spot, strike, riskFreeRate, dividendYield, volatility;
+        boost::int32_t maturity;      // QuantLib date serial number
+        boost::uint32_t fixings;
+    };
+
+    struct Trade {
+        std::string id;
+        bool asian;
+        Option::Type type;
+        Real spot, strike;
+        Rate riskFreeRate, dividendYield;
+        Volatility volatility;
+        Date maturity;
+        Size fixings;
+    };
+
+    struct Config {
+        Size samples, steps;
+        Real tolerance;
+        BigNatural seed;
+        bool sobol, ifConst, binary;
+    };
+
+    std::string trim(const std::string& s) {
+        std::string::size_type first = s.find_first_not_of(" \t\r");
+        if (first == std::string::npos)
+            return "";
+        std::string::size_type last = s.find_last_not_of(" \t\r");
+        return s.substr(first, last-first+1);
+    }
+
+    // strictly positive integer, the whole string
+    Size parsePositive(const std::string& s, const std::string& what) {
+        const char* begin = s.c_str();
+        char* end = 0;
+        errno = 0;
+        long n = std::strtol(begin, &end, 10);
+        QL_REQUIRE(end != begin && *end == '\0' && errno != ERANGE,
+                   what << " is not an integer: " << s);
+        QL_REQUIRE(n > 0, what << " must be positive: " << s);
+        return static_cast<Size>(n);
+    }
+
+    // non-negative integer, the whole string
+    BigNatural parseNatural(const std::string& s, const std::string& what) {
+        const char* begin = s.c_str();
+        char* end = 0;
+        errno = 0;
+        unsigned long n = std::strtoul(begin, &end, 10);
+        QL_REQUIRE(end != begin && *end == '\0' && errno != ERANGE &&
+                   s.find('-') == std::string::npos,
+                   what << " is not a non-negative integer: " << s);
+        return static_cast<BigNatural>(n);
+    }
+
+    // finite real number, the whole string
+    Real parseReal(const std::string& s, const std::string& what) {
+        const char* begin = s.c_str();
+        char* end = 0;
+        errno = 0;
+        double x = std::strtod(begin, &end);
+        QL_REQUIRE(end != begin && *end == '\0' && errno != ERANGE &&
+                   x == x && std::fabs(x) <= QL_MAX_REAL,
+                   what << " is not a number: " << s);
+        return x;
+    }
+
+    // one CSV field, quoted; quotes are doubled and line breaks blanked
+    std::string quoted(const std::string& s) {
+        std::string q = "\"";
+        for (std::string::size_type i=0; i<s.size(); ++i) {
+            if (s[i] == '"')
+                q += "\"\"";
+            else if (s[i] == '\n' || s[i] == '\r')
+                q += ' ';
+            else
+                q += s[i];
+        }
+        return q + "\"";
+    }
+
+    Option::Type parseType(const std::string& s) {
+        if (s == "Call" || s == "call" || s == "C")
+            return Option::Call;
+        if (s == "Put" || s == "put" || s == "P")
+            return Option::Put;
+        QL_FAIL("unknown option type: " << s);
+    }
+
+    const char* const csvColumns[] = { "id", "product", "type", "spot",
+                                       "strike", "r", "q", "vol",
+                                       "maturity", "fixings" };
+
+    // the header line, with or without the fixings column
+    bool isHeader(const std::vector<std::string>& fields) {
+        if (fields.size() != 9 && fields.size() != 10)
+            return false;
+        for (Size i=0; i<fields.size(); ++i)
+            if (fields[i] != csvColumns[i])
+                return false;
+        return true;
+    }
+
+    // returns false for lines to skip; a header is only skipped as the
+    // first line that is neither blank nor a comment
+    bool parseLine(const std::string& line, bool& first, Trade& trade) {
+        std::string l = trim(line);
+        if (l.empty() || l[0] == '#')
+            return false;
+        bool header = first;
+        first = false;
+
+        std::vector<std::string> fields;
+        std::istringstream in(l);
+        std::string field;
+        while (std::getline(in, field, ','))
+            fields.push_back(trim(field));
+        if (header && isHeader(fields))
+            return false;
+        QL_REQUIRE(fields.size() >= 9,
+                   "expected at least 9 fields, got " << fields.size());
+
+        trade.id = fields[0];
+        if (fields[1] == "European")
+            trade.asian = false;
+        else if (fields[1] == "Asian")
+            trade.asian = true;
+        else
+            QL_FAIL("unknown product: " << fields[1]);
+        trade.type = parseType(fields[2]);
+        trade.spot = parseReal(fields[3], "spot");
+        trade.strike = parseReal(fields[4], "strike");
+        trade.riskFreeRate = parseReal(fields[5], "r");
+        trade.dividendYield = parseReal(fields[6], "q");
+        trade.volatility = parseReal(fields[7], "vol");
+        trade.maturity = DateParser::parseISO(fields[8]);
+        trade.fixings = 0;
+        if (trade.asian) {
+            QL_REQUIRE(fields.size() > 9, "no fixings given");
+            trade.fixings = parsePositive(fields[9], "fixings");
+        }
+        return true;
+    }
+
+    void convert(const BinaryTrade& record, Trade& trade) {
+        std::ostringstream id;
+        id << record.id;
+        trade.id = id.str();
+        QL_REQUIRE(record.product <= 1,
+                   "unknown product code: " << record.product);
+        QL_REQUIRE(record.type <= 1,
+                   "unknown option type code: " << record.type);
+        trade.asian = (record.product == 1);
+        trade.type = (record.type == 0 ? Option::Call : Option::Put);
+        trade.spot = record.spot;
+        trade.strike = record.strike;
+        trade.riskFreeRate = record.riskFreeRate;
+        trade.dividendYield = record.dividendYield;
+        trade.volatility = record.volatility;
+        trade.maturity = Date(static_cast<BigInteger>(record.maturity));
+        trade.fixings = record.fixings;
+    }
+
+    template <class RNG>
+    boost::shared_ptr<PricingEngine> europeanEngine(
+              const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+              const Config& config) {
+        MakeMCEuropeanConstEngine<RNG> engine(process, config.ifConst);
+        engine.withSteps(config.steps).withSeed(config.seed);
+        if (config.tolerance != Null<Real>())
+            engine.withAbsoluteTolerance(config.tolerance);
+        else
+            engine.withSamples(config.samples);
+        return engine;
+    }
+
+    template <class RNG>
+    boost::shared_ptr<PricingEngine> asianEngine(
+              const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+              const Config& config) {
+        MakeMCDiscreteArithmeticAPConstEngine<RNG> engine(process,
+                                                          config.ifConst);
+        engine.withSeed(config.seed);
+        if (config.tolerance != Null<Real>())
+            engine.withAbsoluteTolerance(config.tolerance);
+        else
+            engine.withSamples(config.samples);
+        return engine;
+    }
+
+    /* Market objects are built once; each trade only resets the quotes,
+       and the two engines are shared by all the instruments. */
+    class BatchPricer {
+      public:
+        BatchPricer(const Config& config, std::ostream& out)
+        : config_(config), out_(out),
+          spot_(new SimpleQuote(0.0)), riskFreeRate_(new SimpleQuote(0.0)),
+          dividendYield_(new SimpleQuote(0.0)),
+          volatility_(new SimpleQuote(0.0)) {
+            Date today = Settings::instance().evaluationDate();
+            DayCounter dayCounter = Actual365Fixed();
+            Handle<YieldTermStructure> riskFreeTS(
+                boost::shared_ptr<YieldTermStructure>(
+                    new FlatForward(today, Handle<Quote>(riskFreeRate_),
+                                    dayCounter)));
+            Handle<YieldTermStructure> dividendTS(
+                boost::shared_ptr<YieldTermStructure>(
+                    new FlatForward(today, Handle<Quote>(dividendYield_),
+                                    dayCounter)));
+            Handle<BlackVolTermStructure> volTS(
+                boost::shared_ptr<BlackVolTermStructure>(
+                    new BlackConstantVol(today, NullCalendar(),
+                                         Handle<Quote>(volatility_),
+                                         dayCounter)));
+            boost::shared_ptr<GeneralizedBlackScholesProcess> process(
+                new BlackScholesMertonProcess(Handle<Quote>(spot_),
+                                              dividendTS, riskFreeTS, volTS));
+            if (config.sobol) {
+                europeanEngine_ = europeanEngine<LowDiscrepancy>(process, config);
+                asianEngine_ = asianEngine<LowDiscrepancy>(process, config);
+            } else {
+                europeanEngine_ = europeanEngine<PseudoRandom>(process, config);
+                asianEngine_ = asianEngine<PseudoRandom>(process, config);
+            }
+        }
+
+        void price(const Trade& trade) {
+            spot_->setValue(trade.spot);
+            riskFreeRate_->setValue(trade.riskFreeRate);
+            dividendYield_->setValue(trade.dividendYield);
+            volatility_->setValue(trade.volatility);
+
+            boost::shared_ptr<StrikedTypePayoff> payoff(
+                new PlainVanillaPayoff(trade.type, trade.strike));
+            boost::shared_ptr<Exercise> exercise(
+                new EuropeanExercise(trade.maturity));
+
+            boost::shared_ptr<Instrument> option;
+            if (trade.asian) {
+                QL_REQUIRE(trade.fixings > 0, "no fixings given");
+                Date today = Settings::instance().evaluationDate();
+                Real span = trade.maturity - today;
+                std::vector<Date> fixingDates(trade.fixings);
+                for (Size i=0; i<trade.fixings; ++i)
+                    fixingDates[i] = today + static_cast<Integer>(
+                                         span*(i+1)/trade.fixings + 0.5);
+                option = boost::shared_ptr<Instrument>(
+                    new DiscreteAveragingAsianOption(Average::Arithmetic,
+                                                     0.0, 0, fixingDates,
+                                                     payoff, exercise));
+                option->setPricingEngine(asianEngine_);
+            } else {
+                option = boost::shared_ptr<Instrument>(
+                    new VanillaOption(payoff, exercise));
+                option->setPricingEngine(europeanEngine_);
+            }
+
+            clock_t t1 = clock();
+            Real npv = option->NPV();
+            clock_t t2 = clock();
+
+            out_ << trade.id << "," << npv << ",";
+            if (!config_.sobol)
+                out_ << option->errorEstimate();
+            out_ << "," << 1000.0*(t2-t1)/CLOCKS_PER_SEC << ",ok,\n";
+        }
+
+        void fail(const std::string& id, const std::string& message) {
+            out_ << id << ",,,,failed," << quoted(message) << "\n";
+        }
+      private:
+        Config config_;
+        std::ostream& out_;
+        boost::shared_ptr<SimpleQuote> spot_, riskFreeRate_;
+        boost::shared_ptr<SimpleQuote> dividendYield_, volatility_;
+        boost::shared_ptr<PricingEngine> europeanEngine_, asianEngine_;
+    };
+
+    void usage() {
+        std::cerr << "usage: batchpricer [--samples n | --tolerance x] "
+                  << "[--steps n] [--seed n] [--sobol] [--noconst] "
+                  << "[--binary] [--date yyyy-mm-dd] input [output]"
+                  << std::endl;
+    }
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+    try {
+
+        Config config;
+        config.samples = 32768;
+        config.steps = 1;
+        config.tolerance = Null<Real>();
+        config.seed = 42;
+        config.sobol = false;
+        config.ifConst = true;
+        config.binary = false;
+
+        std::vector<std::string> files;
+        for (int i=1; i<argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = (i+1 < argc);
+            if (arg == "--samples" && hasValue) {
+                config.samples = parsePositive(argv[++i], "--samples");
+            } else if (arg == "--tolerance" && hasValue) {
+                config.tolerance = parseReal(argv[++i], "--tolerance");
+                QL_REQUIRE(config.tolerance > 0.0,
+                           "--tolerance must be positive");
+            } else if (arg == "--steps" && hasValue) {
+                config.steps = parsePositive(argv[++i], "--steps");
+            } else if (arg == "--seed" && hasValue) {
+                config.seed = parseNatural(argv[++i], "--seed");
+            } else if (arg == "--sobol") {
+                config.sobol = true;
+            } else if (arg == "--noconst") {
+                config.ifConst = false;
+            } else if (arg == "--binary") {
+                config.binary = true;
+            } else if (arg == "--date" && hasValue) {
+                Settings::instance().evaluationDate() =
+                    DateParser::parseISO(argv[++i]);
+            } else if (arg.size() > 1 && arg[0] == '-' && arg[1] == '-') {
+                usage();
+                return 1;
+            } else {
+                files.push_back(arg);
+            }
+        }
+        if (files.empty() || files.size() > 2) {
+            usage();
+            return 1;
+        }
+        QL_REQUIRE(!(config.sobol && config.tolerance != Null<Real>()),
+                   "low-discrepancy sequences do not allow an error estimate");
+
+        const std::string& input = files[0];
+        if (input.size() > 4 && input.compare(input.size()-4, 4, ".bin") == 0)
+            config.binary = true;
+
+        std::ofstream outFile;
+        if (files.size() == 2) {
+            outFile.open(files[1].c_str());
+            QL_REQUIRE(outFile, "cannot open " << files[1]);
+        }
+        std::ostream& out = (files.size() == 2 ? outFile : std::cout);
+
+        BatchPricer pricer(config, out);
+        out << "id,npv,error,ms,status,message\n";
+
+        if (config.binary) {
+            FILE* in = (input == "-" ? stdin : std::fopen(input.c_str(), "rb"));
+            QL_REQUIRE(in, "cannot open " << input);
+            BinaryTrade record;
+            Trade trade;
+            while (std::fread(&record, sizeof(BinaryTrade), 1, in) == 1) {
+                try {
+                    convert(record, trade);
+                    pricer.price(trade);
+                } catch (std::exception& e) {
+                    std::ostringstream id;
+                    id << record.id;
+                    pricer.fail(id.str(), e.what());
+                }
+            }
+            if (in != stdin)
+                std::fclose(in);
+        } else {
+            std::ifstream inFile;
+            if (input != "-") {
+                inFile.open(input.c_str());
+                QL_REQUIRE(inFile, "cannot open " << input);
+            }
+            std::istream& in = (input == "-" ? std::cin : inFile);
+            std::string line;
+            Trade trade;
+            bool first = true;
+            while (std::getline(in, line)) {
+                try {
+                    if (parseLine(line, first, trade))
+                        pricer.price(trade);
+                } catch (std::exception& e) {
+                    pricer.fail(trim(line.substr(0, line.find(','))),
+                                e.what());
+                }
+            }
+        }
+        out.flush();
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+        return 1;
+    }
+
+}
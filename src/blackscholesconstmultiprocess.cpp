@@ -0,0 +1,131 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "./blackscholesconstmultiprocess.hpp"
+#include <ql/math/matrixutilities/choleskydecomposition.hpp>
+#include <math.h>
+
+
+namespace QuantLib {
+
+    BlackScholesConstMultiProcess::BlackScholesConstMultiProcess(
+        const Date& exercisedate,
+        const std::vector<boost::shared_ptr<GeneralizedBlackScholesProcess> >&
+                                                                processes,
+        const Matrix& correlation)
+    : size_(processes.size()), x0_(processes.size()),
+      riskFreeForward_(processes.size()), dividendForward_(processes.size()),
+      sigma_(processes.size()), drift_(processes.size()),
+      correlation_(correlation), diffusion_(processes.size(),
+                                            processes.size(), 0.0) {
+
+        QL_REQUIRE(size_ > 0, "no processes given");
+        QL_REQUIRE(correlation.rows() == size_ &&
+                   correlation.columns() == size_,
+                   "correlation matrix has wrong size ("
+                   << correlation.rows() << "x" << correlation.columns()
+                   << ", " << size_ << "x" << size_ << " required)");
+
+        riskFreeRate_ = processes[0]->riskFreeRate();
+        Time dt = time(exercisedate);
+
+        for (Size i=0; i<size_; ++i) {
+            x0_[i] = processes[i]->stateVariable();
+            riskFreeForward_[i] = processes[i]->riskFreeRate()->zeroRate(
+                                        dt, Continuous, NoFrequency, true);
+            dividendForward_[i] = processes[i]->dividendYield()->zeroRate(
+                                        dt, Continuous, NoFrequency, true);
+            sigma_[i] = processes[i]->blackVolatility()->blackVol(
+                                        dt, x0_[i]->value(), true);
+            drift_[i] = riskFreeForward_[i] - dividendForward_[i]
+                      - 0.5 * sigma_[i] * sigma_[i];
+        }
+
+        Matrix sqrtCorrelation = CholeskyDecomposition(correlation_, true);
+        for (Size i=0; i<size_; ++i)
+            for (Size j=0; j<=i; ++j)
+                diffusion_[i][j] = sigma_[i] * sqrtCorrelation[i][j];
+    }
+
+    Size BlackScholesConstMultiProcess::size() const {
+        return size_;
+    }
+
+    Size BlackScholesConstMultiProcess::factors() const {
+        return size_;
+    }
+
+    Disposable<Array> BlackScholesConstMultiProcess::initialValues() const {
+        Array tmp(size_);
+        for (Size i=0; i<size_; ++i)
+            tmp[i] = x0_[i]->value();
+        return tmp;
+    }
+
+    Disposable<Array> BlackScholesConstMultiProcess::drift(Time,
+                                                           const Array&) const {
+        Array tmp(size_);
+        std::copy(drift_.begin(), drift_.end(), tmp.begin());
+        return tmp;
+    }
+
+    Disposable<Matrix> BlackScholesConstMultiProcess::diffusion(
+                                                  Time, const Array&) const {
+        Matrix tmp = diffusion_;
+        return tmp;
+    }
+
+    Disposable<Array> BlackScholesConstMultiProcess::apply(
+                                 const Array& x0, const Array& dx) const {
+        Array tmp(size_);
+        for (Size i=0; i<size_; ++i)
+            tmp[i] = x0[i] * std::exp(dx[i]);
+        return tmp;
+    }
+
+    Disposable<Array> BlackScholesConstMultiProcess::evolve(
+                                 Time, const Array& x0,
+                                 Time dt, const Array& dw) const {
+        // one pass over the lower triangle: correlate, scale and
+        // exponentiate without going through drift()/diffusion()
+        Array tmp(size_);
+        Real sqrtDt = std::sqrt(dt);
+        for (Size i=0; i<size_; ++i) {
+            Matrix::const_row_iterator row = diffusion_.row_begin(i);
+            Real dx = 0.0;
+            for (Size j=0; j<=i; ++j)
+                dx += row[j] * dw[j];
+            tmp[i] = x0[i] * std::exp(drift_[i]*dt + dx*sqrtDt);
+        }
+        return tmp;
+    }
+
+    Time BlackScholesConstMultiProcess::time(const Date& d) const {
+        return riskFreeRate_->dayCounter().yearFraction(
+                                           riskFreeRate_->referenceDate(), d);
+    }
+
+    const Matrix& BlackScholesConstMultiProcess::correlation() const {
+        return correlation_;
+    }
+
+    Rate BlackScholesConstMultiProcess::riskFreeForward(Size i) const {
+        return riskFreeForward_.at(i);
+    }
+
+    Rate BlackScholesConstMultiProcess::dividendForward(Size i) const {
+        return dividendForward_.at(i);
+    }
+
+    Volatility BlackScholesConstMultiProcess::volatility(Size i) const {
+        return sigma_.at(i);
+    }
+
+}
@@ -0,0 +1,73 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file blackscholesconstmultiprocess.hpp
+    \brief correlated multi-asset Black-Scholes process with const parameters
+*/
+
+#ifndef quantlib_black_scholes_const_multi_process_hpp
+#define quantlib_black_scholes_const_multi_process_hpp
+
+#include <ql/stochasticprocess.hpp>
+#include <ql/processes/blackscholesprocess.hpp>
+#include <ql/math/matrix.hpp>
+#include <vector>
+
+namespace QuantLib {
+
+    //! multi-asset Black-Scholes process with frozen parameters
+    /*! Each asset gets its own r, q and sigma frozen at the exercise
+        date, in the same way as BlackScholesConstProcess. The
+        correlation is constant; its Cholesky factor is computed once
+        in the constructor and stored already scaled by the asset
+        volatilities, so that evolve() is a single fused loop over a
+        lower-triangular matrix with no term-structure calls.
+    */
+    class BlackScholesConstMultiProcess : public StochasticProcess {
+      public:
+        BlackScholesConstMultiProcess(
+        const Date& exercisedate,
+        const std::vector<boost::shared_ptr<GeneralizedBlackScholesProcess> >&
+                                                                processes,
+        const Matrix& correlation);
+
+        Size size() const;
+        Size factors() const;
+
+        Disposable<Array> initialValues() const;
+        Disposable<Array> drift(Time t, const Array& x) const;
+        Disposable<Matrix> diffusion(Time t, const Array& x) const;
+
+        Disposable<Array> apply(const Array& x0, const Array& dx) const;
+        Disposable<Array> evolve(Time t0, const Array& x0,
+                                 Time dt, const Array& dw) const;
+
+        Time time(const Date&) const;
+
+        const Matrix& correlation() const;
+        Rate riskFreeForward(Size i) const;
+        Rate dividendForward(Size i) const;
+        Volatility volatility(Size i) const;
+
+      private:
+        Size size_;
+        std::vector<Handle<Quote> > x0_;
+        Handle<YieldTermStructure> riskFreeRate_;
+        std::vector<Rate> riskFreeForward_, dividendForward_;
+        std::vector<Real> sigma_, drift_;
+        Matrix correlation_;
+        // sigma_i * L_ij with L the Cholesky factor of correlation_
+        Matrix diffusion_;
+    };
+
+}
+
+
+#endif
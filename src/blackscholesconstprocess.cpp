@@ -34,18 +34,28 @@ namespace QuantLib {
     : StochasticProcess1D(disc), x0_(x0), riskFreeRate_(riskFreeTS),
       dividendYield_(dividendTS), blackVolatility_(blackVolTS) {
           
+        freeze(exercisedate);
+      }
+
+    BlackScholesConstProcess::BlackScholesConstProcess(
+             const Handle<Quote>& x0,
+             Rate riskFreeForward,
+             Rate dividendForward,
+             Volatility volatility,
+             const boost::shared_ptr<discretization>& disc)
+    : StochasticProcess1D(disc), sigma(volatility), x0_(x0),
+      riskFreeForward_(riskFreeForward), dividendForward_(dividendForward) {
+
+        drift_ = riskFreeForward_ - dividendForward_ - 0.5 * sigma * sigma;
+      }
+
+    void BlackScholesConstProcess::freeze(const Date& exercisedate) {
         Time dt = time(exercisedate);
         riskFreeForward_ = riskFreeRate_->zeroRate(dt, Continuous, NoFrequency, true);
         dividendForward_ = dividendYield_->zeroRate(dt, Continuous, NoFrequency, true);
-        sigma = blackVolatility_->blackVol(dt, x0->value(), true);
+        sigma = blackVolatility_->blackVol(dt, x0_->value(), true);
         drift_ = riskFreeForward_ - dividendForward_ - 0.5 * sigma * sigma;
-        expectation_ = dt*drift_;
-        stdDev_ = sqrt(dt)*sigma ;
-        cout << "====const process=====" << endl;
-        cout << "dt = " << dt << "  sigma = " << sigma <<" "<< "riskFreeForward = " << riskFreeForward_ << " " << "dividendForward = " << dividendForward_ << " "<< "drift = " << drift_ << endl;
-        cout << "======================" << endl;
-
-      }
+    }
 
     Real BlackScholesConstProcess::x0() const {
          
@@ -79,12 +89,14 @@ namespace QuantLib {
     Real BlackScholesConstProcess::evolve(Time t0, Real x0,
                                                 Time dt, Real dw) const {
         //http://quantlib.org/reference/class_quant_lib_1_1_generalized_black_scholes_process.html
-        //http://quantlib.org/slides/dima-ql-intro-2.pdf       
-        return apply(x0, expectation_ + dw*stdDev_);
+        //http://quantlib.org/slides/dima-ql-intro-2.pdf
+        // dt is the length of the step, not the time to exercise
+        return apply(x0, drift_*dt + dw*sigma*std::sqrt(dt));
     }
 
     Time BlackScholesConstProcess::time(const Date& d) const {
-         
+        QL_REQUIRE(!riskFreeRate_.empty(),
+                   "no risk-free curve given");
         return riskFreeRate_->dayCounter().yearFraction(
                                            riskFreeRate_->referenceDate(), d);
     }
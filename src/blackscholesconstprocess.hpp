@@ -36,9 +36,25 @@ namespace QuantLib {
         const Handle<YieldTermStructure>& riskFreeTS,
         const Handle<BlackVolTermStructure>& blackVolTS,
         // TODO initial here or not
+        const boost::shared_ptr<discretization>& d =
+                  boost::shared_ptr<discretization>(new EulerDiscretization));
+        //! build from already frozen values, e.g. read from a snapshot
+        /*! No term structure is stored, so time() and the term-structure
+            inspectors cannot be used on such a process.
+        */
+        BlackScholesConstProcess(
+        const Handle<Quote>& x0,
+        Rate riskFreeForward,
+        Rate dividendForward,
+        Volatility volatility,
         const boost::shared_ptr<discretization>& d =
                   boost::shared_ptr<discretization>(new EulerDiscretization));
         
+        //! freezes r, q and sigma again from the curves
+        /*! Lets a process shared by a cached path generator follow the
+            market; requires the term-structure constructor. */
+        void freeze(const Date& exercisedate);
+
         Real x0() const;
         
         Real drift(Time t=0, Real x=0) const;
@@ -70,8 +86,6 @@ namespace QuantLib {
 	    Rate riskFreeForward_;
 	    Rate dividendForward_;
         Real drift_;
-        Real expectation_;
-        Real stdDev_;
         //mutable bool updated_, isStrikeIndependent_;
     };
 
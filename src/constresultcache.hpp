@@ -0,0 +1,132 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file constresultcache.hpp
+    \brief bounded LRU cache of const-engine results
+*/
+
+#ifndef quantlib_const_result_cache_hpp
+#define quantlib_const_result_cache_hpp
+
+#include <ql/errors.hpp>
+#include <ql/types.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <cstring>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace QuantLib {
+
+    //! LRU cache of Monte Carlo results keyed on the frozen inputs
+    /*! With frozen parameters a const-engine price only depends on a
+        handful of numbers: spot, r, q, sigma, the time grid, the
+        payoff, the generator and its seed, and the sample settings.
+        The engines put all of them in a Key; the key is hashed
+        (FNV-1a) for the lookup and compared in full on a hit, so a
+        hash collision is a miss, never a wrong price.
+
+        One cache can be shared by several engines. It is not
+        synchronized.
+    */
+    class ConstResultCache : private boost::noncopyable {
+      public:
+        class Key {
+          public:
+            explicit Key(const std::string& tag)
+            : tag_(tag), hash_(14695981039346656037ULL) {
+                mix(tag.data(), tag.size());
+            }
+            Key& operator<<(Real x) {
+                values_.push_back(x);
+                mix(reinterpret_cast<const char*>(&x), sizeof(Real));
+                return *this;
+            }
+            boost::uint64_t hash() const { return hash_; }
+            bool operator==(const Key& other) const {
+                return hash_ == other.hash_ && tag_ == other.tag_
+                    && values_ == other.values_;
+            }
+          private:
+            void mix(const char* p, Size n) {
+                for (Size i=0; i<n; ++i) {
+                    hash_ ^= static_cast<unsigned char>(p[i]);
+                    hash_ *= 1099511628211ULL;
+                }
+            }
+            std::string tag_;
+            std::vector<Real> values_;
+            boost::uint64_t hash_;
+        };
+
+        explicit ConstResultCache(Size capacity = 1024)
+        : capacity_(capacity), hits_(0), misses_(0) {
+            QL_REQUIRE(capacity_ > 0, "null cache capacity");
+        }
+
+        //! returns true and fills the results on a hit
+        bool find(const Key& key, Real& value, Real& errorEstimate) {
+            index_type::iterator i = index_.find(key.hash());
+            if (i == index_.end() || !(i->second->key == key)) {
+                ++misses_;
+                return false;
+            }
+            // most recently used goes to the front
+            entries_.splice(entries_.begin(), entries_, i->second);
+            value = i->second->value;
+            errorEstimate = i->second->errorEstimate;
+            ++hits_;
+            return true;
+        }
+
+        void insert(const Key& key, Real value, Real errorEstimate) {
+            index_type::iterator i = index_.find(key.hash());
+            if (i != index_.end()) {
+                entries_.erase(i->second);
+                index_.erase(i);
+            } else if (entries_.size() == capacity_) {
+                index_.erase(entries_.back().key.hash());
+                entries_.pop_back();
+            }
+            Entry e = { key, value, errorEstimate };
+            entries_.push_front(e);
+            index_[key.hash()] = entries_.begin();
+        }
+
+        void clear() {
+            entries_.clear();
+            index_.clear();
+        }
+
+        Size size() const { return entries_.size(); }
+        Size capacity() const { return capacity_; }
+        Size hits() const { return hits_; }
+        Size misses() const { return misses_; }
+
+      private:
+        struct Entry {
+            Key key;
+            Real value, errorEstimate;
+        };
+        typedef std::list<Entry> list_type;
+        typedef std::map<boost::uint64_t, list_type::iterator> index_type;
+
+        Size capacity_;
+        Size hits_, misses_;
+        list_type entries_;
+        index_type index_;
+    };
+
+}
+
+
+#endif
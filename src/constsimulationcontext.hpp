@@ -0,0 +1,166 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file constsimulationcontext.hpp
+    \brief path generator kept warm across calculations
+*/
+
+#ifndef quantlib_const_simulation_context_hpp
+#define quantlib_const_simulation_context_hpp
+
+#include <ql/processes/blackscholesprocess.hpp>
+#include <ql/timegrid.hpp>
+#include <ql/math/randomnumbers/sobolrsg.hpp>
+#include "./blackscholesconstprocess.hpp"
+#include <algorithm>
+
+namespace QuantLib {
+
+    namespace detail {
+
+        // moves a fresh uniform sequence generator n sequences ahead
+        template <class URSG>
+        void skipSequences(URSG& uniforms, Size n) {
+            for (Size i=0; i<n; ++i)
+                uniforms.nextSequence();
+        }
+
+        // Sobol sequences are positioned directly
+        inline void skipSequences(SobolRsg& uniforms, Size n) {
+            uniforms.skipTo(n);
+        }
+
+    }
+
+    //! pristine path generator on frozen parameters
+    /*! Building a path generator makes the sequence generator (for
+        Sobol, the direction integers), the Brownian-bridge weights and
+        the time grid. The context builds them once, on its own
+        BlackScholesConstProcess, and keeps that generator unused as a
+        prototype; every calculation gets a copy, which starts from the
+        seed again. When only the market moves, the process is frozen
+        again in place and the prototype is kept; it is only rebuilt
+        when the time grid changes.
+
+        A zero seed asks for a random seed on every run, as the other
+        engines do: the generator is then rebuilt on each call, and
+        only the process is kept.
+
+        A generator handed out earlier shares the process, so it
+        follows the new frozen values too; the engines never reuse one
+        across a change of inputs.
+
+        With setFirstSample(n) the generator starts at the n-th
+        sequence of the seed's stream, so that several engines on the
+        same seed can simulate disjoint, contiguous parts of one run.
+        Sobol sequences are positioned in one go; other generators
+        draw the skipped sequences as uniforms. setFirstSample(n, drawn)
+        avoids even that when the generator handed out last has
+        already reached the n-th sequence: the next call hands that
+        generator out again, and it goes on where it stopped.
+    */
+    template <class RNG, class PathGeneratorType>
+    class ConstSimulationContext {
+      public:
+        ConstSimulationContext(BigNatural seed, bool brownianBridge)
+        : seed_(seed), brownianBridge_(brownianBridge), firstSample_(0),
+          resume_(false) {}
+
+        Size firstSample() const { return firstSample_; }
+        void setFirstSample(Size n) {
+            resume_ = false;
+            if (n != firstSample_) {
+                firstSample_ = n;
+                prototype_.reset();
+            }
+        }
+        //! as above, when the last generator handed out drew \c drawn sequences
+        void setFirstSample(Size n, Size drawn) {
+            if (last_ && n != firstSample_ && firstSample_ + drawn == n) {
+                firstSample_ = n;
+                prototype_.reset();
+                resume_ = true;
+            } else {
+                setFirstSample(n);
+            }
+        }
+
+        boost::shared_ptr<PathGeneratorType> pathGenerator(
+               const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+               const Date& exercisedate,
+               const TimeGrid& grid) {
+            if (!process_) {
+                process_ = boost::shared_ptr<BlackScholesConstProcess>(
+                    new BlackScholesConstProcess(exercisedate,
+                                                 process->stateVariable(),
+                                                 process->dividendYield(),
+                                                 process->riskFreeRate(),
+                                                 process->blackVolatility()));
+                prototype_.reset();
+            } else {
+                process_->freeze(exercisedate);
+            }
+
+            bool resume = resume_;
+            resume_ = false;
+            if (resume && sameGrid(grid))
+                return last_;
+
+            if (!prototype_ || seed_ == 0 || !sameGrid(grid)) {
+                grid_ = grid;
+                typename RNG::rsg_type generator = sequenceGenerator(
+                                                          grid.size()-1);
+                prototype_ = boost::shared_ptr<PathGeneratorType>(
+                    new PathGeneratorType(process_, grid,
+                                          generator, brownianBridge_));
+            }
+            last_ = boost::shared_ptr<PathGeneratorType>(
+                                        new PathGeneratorType(*prototype_));
+            return last_;
+        }
+
+        //! drops the prototype; the next call rebuilds everything
+        void reset() {
+            prototype_.reset();
+            process_.reset();
+            last_.reset();
+            resume_ = false;
+        }
+
+      private:
+        typename RNG::rsg_type sequenceGenerator(Size dimension) const {
+            if (firstSample_ == 0)
+                return RNG::make_sequence_generator(dimension, seed_);
+            // as make_sequence_generator, after skipping ahead
+            typename RNG::ursg_type uniforms(dimension, seed_);
+            detail::skipSequences(uniforms, firstSample_);
+            return RNG::icInstance ?
+                typename RNG::rsg_type(uniforms, *RNG::icInstance) :
+                typename RNG::rsg_type(uniforms);
+        }
+
+        bool sameGrid(const TimeGrid& grid) const {
+            return grid.size() == grid_.size() &&
+                   std::equal(grid.begin(), grid.end(), grid_.begin());
+        }
+
+        BigNatural seed_;
+        bool brownianBridge_;
+        Size firstSample_;
+        bool resume_;
+        TimeGrid grid_;
+        boost::shared_ptr<BlackScholesConstProcess> process_;
+        boost::shared_ptr<PathGeneratorType> prototype_, last_;
+    };
+
+}
+
+
+#endif
@@ -0,0 +1,203 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "./hestonconstprocess.hpp"
+#include <algorithm>
+#include <math.h>
+
+
+namespace QuantLib {
+
+    HestonConstProcess::HestonConstProcess(
+                         const Date& exercisedate,
+                         const boost::shared_ptr<HestonProcess>& process)
+    : s0_(process->s0()), riskFreeRate_(process->riskFreeRate()),
+      v0_(process->v0()), kappa_(process->kappa()),
+      theta_(process->theta()), sigma_(process->sigma()),
+      rho_(process->rho()), cursor_(0) {
+
+        QL_REQUIRE(kappa_ > 0.0, "positive mean reversion required");
+        QL_REQUIRE(sigma_ > 0.0, "positive vol of vol required");
+
+        Time dt = time(exercisedate);
+        riskFreeForward_ = process->riskFreeRate()->zeroRate(
+                                        dt, Continuous, NoFrequency, true);
+        dividendForward_ = process->dividendYield()->zeroRate(
+                                        dt, Continuous, NoFrequency, true);
+
+        offGrid_.dt = -1.0;
+    }
+
+    Size HestonConstProcess::size() const {
+        return 2;
+    }
+
+    Size HestonConstProcess::factors() const {
+        return 2;
+    }
+
+    Disposable<Array> HestonConstProcess::initialValues() const {
+        Array tmp(2);
+        tmp[0] = s0_->value();
+        tmp[1] = v0_;
+        return tmp;
+    }
+
+    Disposable<Array> HestonConstProcess::drift(Time,
+                                                const Array& x) const {
+        // full truncation, as in HestonProcess
+        const Real vol = x[1] > 0.0 ? std::sqrt(x[1]) : 0.0;
+        Array tmp(2);
+        tmp[0] = riskFreeForward_ - dividendForward_ - 0.5 * vol * vol;
+        tmp[1] = kappa_ * (theta_ - (x[1] > 0.0 ? x[1] : 0.0));
+        return tmp;
+    }
+
+    Disposable<Matrix> HestonConstProcess::diffusion(Time,
+                                                     const Array& x) const {
+        const Real vol = x[1] > 0.0 ? std::sqrt(x[1]) : 0.0;
+        const Real sigma2 = sigma_ * vol;
+        const Real sqrhov = std::sqrt(1.0 - rho_*rho_);
+        Matrix tmp(2, 2);
+        tmp[0][0] = vol;            tmp[0][1] = 0.0;
+        tmp[1][0] = rho_*sigma2;    tmp[1][1] = sqrhov*sigma2;
+        return tmp;
+    }
+
+    Disposable<Array> HestonConstProcess::apply(const Array& x0,
+                                                const Array& dx) const {
+        Array tmp(2);
+        tmp[0] = x0[0] * std::exp(dx[0]);
+        tmp[1] = x0[1] + dx[1];
+        return tmp;
+    }
+
+    void HestonConstProcess::computeConstants(Time dt,
+                                              StepConstants& c) const {
+        const Real ex = std::exp(-kappa_*dt);
+        const Real xi2 = sigma_*sigma_;
+        const Real gamma1 = 0.5, gamma2 = 0.5;
+        c.dt = dt;
+        c.expKappaDt = ex;
+        c.c1 = xi2*ex*(1.0-ex)/kappa_;
+        c.c2 = theta_*xi2*(1.0-ex)*(1.0-ex)/(2.0*kappa_);
+        c.k0 = -rho_*kappa_*theta_*dt/sigma_;
+        c.k1 = gamma1*dt*(kappa_*rho_/sigma_ - 0.5) - rho_/sigma_;
+        c.k2 = gamma2*dt*(kappa_*rho_/sigma_ - 0.5) + rho_/sigma_;
+        c.k3 = gamma1*dt*(1.0-rho_*rho_);
+        c.k4 = gamma2*dt*(1.0-rho_*rho_);
+    }
+
+    void HestonConstProcess::prepare(const TimeGrid& grid) const {
+        Size n = grid.size() > 0 ? grid.size()-1 : 0;
+        times_.resize(n);
+        steps_.resize(n);
+        for (Size i=0; i<n; ++i) {
+            times_[i] = grid[i];
+            computeConstants(grid.dt(i), steps_[i]);
+        }
+        cursor_ = 0;
+    }
+
+    const HestonConstProcess::StepConstants&
+    HestonConstProcess::constants(Time t0, Time dt) const {
+        // path generators walk the grid in order: try the current and
+        // the next step before searching
+        Size i = cursor_;
+        if (!(i < times_.size() && times_[i] == t0)) {
+            if (i+1 < times_.size() && times_[i+1] == t0)
+                ++i;
+            else
+                i = std::lower_bound(times_.begin(), times_.end(), t0)
+                  - times_.begin();
+        }
+        if (i < times_.size() && times_[i] == t0 && steps_[i].dt == dt) {
+            cursor_ = i;
+            return steps_[i];
+        }
+        if (dt != offGrid_.dt)
+            computeConstants(dt, offGrid_);
+        return offGrid_;
+    }
+
+    Disposable<Array> HestonConstProcess::evolve(Time t0, const Array& x0,
+                                                 Time dt,
+                                                 const Array& dw) const {
+        // Andersen (2008), QE with psi_c = 1.5; dw[0] drives the spot
+        // residual and dw[1] the variance
+        const StepConstants& c = constants(t0, dt);
+        const Real v = std::max(x0[1], 0.0);
+
+        const Real m = theta_ + (v - theta_)*c.expKappaDt;
+        const Real s2 = v*c.c1 + c.c2;
+        const Real psi = s2/(m*m);
+
+        Real vNext;
+        if (psi <= 1.5) {
+            const Real b2 = 2.0/psi - 1.0
+                          + std::sqrt(2.0/psi*(2.0/psi - 1.0));
+            const Real b = std::sqrt(b2);
+            const Real a = m/(1.0+b2);
+            vNext = a*(b+dw[1])*(b+dw[1]);
+        } else {
+            const Real p = (psi-1.0)/(psi+1.0);
+            const Real beta = (1.0-p)/m;
+            const Real u = cumNormal_(dw[1]);
+            vNext = (u <= p) ? 0.0 : std::log((1.0-p)/(1.0-u))/beta;
+        }
+
+        const Real dx = (riskFreeForward_ - dividendForward_)*dt
+                      + c.k0 + c.k1*v + c.k2*vNext
+                      + std::sqrt(c.k3*v + c.k4*vNext)*dw[0];
+
+        Array tmp(2);
+        tmp[0] = x0[0] * std::exp(dx);
+        tmp[1] = vNext;
+        return tmp;
+    }
+
+    Time HestonConstProcess::time(const Date& d) const {
+        return riskFreeRate_->dayCounter().yearFraction(
+                                           riskFreeRate_->referenceDate(), d);
+    }
+
+    Real HestonConstProcess::s0() const {
+        return s0_->value();
+    }
+
+    Real HestonConstProcess::v0() const {
+        return v0_;
+    }
+
+    Real HestonConstProcess::kappa() const {
+        return kappa_;
+    }
+
+    Real HestonConstProcess::theta() const {
+        return theta_;
+    }
+
+    Real HestonConstProcess::sigma() const {
+        return sigma_;
+    }
+
+    Real HestonConstProcess::rho() const {
+        return rho_;
+    }
+
+    Rate HestonConstProcess::riskFreeForward() const {
+        return riskFreeForward_;
+    }
+
+    Rate HestonConstProcess::dividendForward() const {
+        return dividendForward_;
+    }
+
+}
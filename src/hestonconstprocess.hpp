@@ -0,0 +1,104 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file hestonconstprocess.hpp
+    \brief Heston process with const parameters
+*/
+
+#ifndef quantlib_heston_const_process_hpp
+#define quantlib_heston_const_process_hpp
+
+#include <ql/stochasticprocess.hpp>
+#include <ql/processes/hestonprocess.hpp>
+#include <ql/math/distributions/normaldistribution.hpp>
+#include <ql/timegrid.hpp>
+#include <vector>
+
+namespace QuantLib {
+
+    //! Heston process with frozen rates
+    /*! r and q are frozen at the exercise date as in
+        BlackScholesConstProcess; kappa, theta, xi (sigma) and rho are
+        constant in the Heston model already. The state is (S, v) as
+        in HestonProcess.
+
+        evolve() uses Andersen's quadratic-exponential scheme for the
+        variance and the matching log-spot step with
+        \f$ \gamma_1 = \gamma_2 = 1/2 \f$. Everything that only
+        depends on the step length (the mean-reversion factor, the
+        variance coefficients and K0..K4) is tabulated per step of the
+        TimeGrid by prepare(), once per run, and looked up by step.
+        A step on any grid, regular or not, then costs one exponential
+        and one square root for the spot, plus two square roots in the
+        quadratic branch of the variance step, or one normal cumulative
+        and one logarithm in the exponential branch. Steps off the
+        prepared grid compute their constants on the fly, one more
+        exponential whenever the step length changes.
+
+        The lookup keeps a mutable cursor on the prepared grid, so a
+        process must not be used by several threads at once.
+    */
+    class HestonConstProcess : public StochasticProcess {
+      public:
+        HestonConstProcess(const Date& exercisedate,
+                           const boost::shared_ptr<HestonProcess>& process);
+
+        Size size() const;
+        Size factors() const;
+
+        Disposable<Array> initialValues() const;
+        Disposable<Array> drift(Time t, const Array& x) const;
+        Disposable<Matrix> diffusion(Time t, const Array& x) const;
+
+        Disposable<Array> apply(const Array& x0, const Array& dx) const;
+        Disposable<Array> evolve(Time t0, const Array& x0,
+                                 Time dt, const Array& dw) const;
+
+        Time time(const Date&) const;
+
+        //! tabulates the step constants for every step of the grid
+        void prepare(const TimeGrid& grid) const;
+
+        Real s0() const;
+        Real v0() const;
+        Real kappa() const;
+        Real theta() const;
+        Real sigma() const;
+        Real rho() const;
+        Rate riskFreeForward() const;
+        Rate dividendForward() const;
+
+      private:
+        struct StepConstants {
+            Time dt;
+            Real expKappaDt;
+            // conditional variance of v is c1*v + c2
+            Real c1, c2;
+            Real k0, k1, k2, k3, k4;
+        };
+        void computeConstants(Time dt, StepConstants& c) const;
+        const StepConstants& constants(Time t0, Time dt) const;
+
+        Handle<Quote> s0_;
+        Handle<YieldTermStructure> riskFreeRate_;
+        Real v0_, kappa_, theta_, sigma_, rho_;
+        Rate riskFreeForward_, dividendForward_;
+        CumulativeNormalDistribution cumNormal_;
+        // step constants of the prepared grid, by step start time
+        mutable std::vector<Time> times_;
+        mutable std::vector<StepConstants> steps_;
+        mutable Size cursor_;
+        mutable StepConstants offGrid_;
+    };
+
+}
+
+
+#endif
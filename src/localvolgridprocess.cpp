@@ -0,0 +1,135 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "./localvolgridprocess.hpp"
+#include <algorithm>
+#include <math.h>
+
+
+namespace QuantLib {
+
+    LocalVolGridProcess::LocalVolGridProcess(
+            const Date& exercisedate,
+            const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+            const TimeGrid& grid,
+            Size spotNodes,
+            Real stdDevs,
+            const boost::shared_ptr<discretization>& disc)
+    : StochasticProcess1D(disc), x0_(process->stateVariable()),
+      riskFreeRate_(process->riskFreeRate()), spotNodes_(spotNodes),
+      cursor_(0), lastSpot_(Null<Real>()), lastLogSpot_(0.0) {
+
+        QL_REQUIRE(spotNodes_ > 1, "at least two spot nodes required");
+        QL_REQUIRE(grid.size() > 1, "empty time grid given");
+
+        Time T = time(exercisedate);
+        riskFreeForward_ = process->riskFreeRate()->zeroRate(
+                                        T, Continuous, NoFrequency, true);
+        dividendForward_ = process->dividendYield()->zeroRate(
+                                        T, Continuous, NoFrequency, true);
+
+        Real spot = x0_->value();
+        Volatility atmVol = process->blackVolatility()->blackVol(
+                                        T, spot, true);
+        Real center = std::log(spot);
+        Real halfWidth = std::fabs(riskFreeForward_ - dividendForward_)*T
+                       + stdDevs*atmVol*std::sqrt(T);
+        QL_REQUIRE(halfWidth > 0.0, "degenerate log-spot range");
+        xMin_ = center - halfWidth;
+        dx_ = 2.0*halfWidth/(spotNodes_-1);
+        invDx_ = 1.0/dx_;
+
+        // one row per step, sampled at the start of the step
+        times_.assign(grid.begin(), grid.end()-1);
+        table_.resize(times_.size()*spotNodes_);
+        const boost::shared_ptr<LocalVolTermStructure>& localVol =
+            process->localVolatility().currentLink();
+        for (Size i=0; i<times_.size(); ++i) {
+            Volatility* r = &table_[i*spotNodes_];
+            for (Size j=0; j<spotNodes_; ++j)
+                r[j] = localVol->localVol(times_[i],
+                                          std::exp(xMin_ + j*dx_), true);
+        }
+    }
+
+    Real LocalVolGridProcess::x0() const {
+        return x0_->value();
+    }
+
+    Real LocalVolGridProcess::drift(Time t, Real x) const {
+        Volatility sigma = localVol(t, x);
+        return riskFreeForward_ - dividendForward_ - 0.5 * sigma * sigma;
+    }
+
+    Real LocalVolGridProcess::diffusion(Time t, Real x) const {
+        return localVol(t, x);
+    }
+
+    Real LocalVolGridProcess::apply(Real x0, Real dx) const {
+        return x0 * std::exp(dx);
+    }
+
+    Size LocalVolGridProcess::row(Time t) const {
+        // paths walk the grid forward, so the next row is almost
+        // always the cursor or the one after it
+        if (times_[cursor_] == t)
+            return cursor_;
+        if (cursor_+1 < times_.size() && times_[cursor_+1] == t)
+            return ++cursor_;
+        std::vector<Time>::const_iterator i =
+            std::upper_bound(times_.begin(), times_.end(), t);
+        cursor_ = (i == times_.begin() ? 0 : (i - times_.begin()) - 1);
+        return cursor_;
+    }
+
+    Volatility LocalVolGridProcess::lookup(Size row, Real logSpot) const {
+        const Volatility* r = &table_[row*spotNodes_];
+        Real u = (logSpot - xMin_)*invDx_;
+        if (u <= 0.0)
+            return r[0];
+        Size j = static_cast<Size>(u);
+        if (j >= spotNodes_-1)
+            return r[spotNodes_-1];
+        Real w = u - j;
+        return r[j] + w*(r[j+1]-r[j]);
+    }
+
+    Volatility LocalVolGridProcess::localVol(Time t, Real spot) const {
+        return lookup(row(t), std::log(spot));
+    }
+
+    Real LocalVolGridProcess::evolve(Time t0, Real x0,
+                                     Time dt, Real dw) const {
+        // a path feeds back the spot returned by the last step, whose
+        // log is known; only the first step of a path takes a log
+        if (x0 != lastSpot_)
+            lastLogSpot_ = std::log(x0);
+        Volatility sigma = lookup(row(t0), lastLogSpot_);
+        Real dx = (riskFreeForward_ - dividendForward_ - 0.5*sigma*sigma)*dt
+                + sigma*std::sqrt(dt)*dw;
+        lastLogSpot_ += dx;
+        lastSpot_ = std::exp(lastLogSpot_);
+        return lastSpot_;
+    }
+
+    Time LocalVolGridProcess::time(const Date& d) const {
+        return riskFreeRate_->dayCounter().yearFraction(
+                                           riskFreeRate_->referenceDate(), d);
+    }
+
+    Rate LocalVolGridProcess::riskFreeForward() const {
+        return riskFreeForward_;
+    }
+
+    Rate LocalVolGridProcess::dividendForward() const {
+        return dividendForward_;
+    }
+
+}
@@ -0,0 +1,93 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file localvolgridprocess.hpp
+    \brief Black-Scholes process on a precomputed local-volatility grid
+*/
+
+#ifndef quantlib_local_vol_grid_process_hpp
+#define quantlib_local_vol_grid_process_hpp
+
+#include <ql/stochasticprocess.hpp>
+#include <ql/processes/blackscholesprocess.hpp>
+#include <ql/processes/eulerdiscretization.hpp>
+#include <ql/timegrid.hpp>
+#include <vector>
+
+namespace QuantLib {
+
+    //! Black-Scholes process with frozen rates and a tabulated local vol
+    /*! r and q are frozen at the exercise date as in
+        BlackScholesConstProcess. The local volatility of the real
+        process is sampled once, at the start of every step of the
+        engine's time grid and on a uniform log-spot axis, and stored
+        row by row in a single flat table. evolve() finds the row of
+        the step with a cursor that follows the path forward, and
+        interpolates linearly in log-spot inside the row; outside the
+        axis the end values are used. The Dupire surface is never
+        called while paths are generated.
+
+        evolve() carries the log-spot of the spot it returned last, so
+        a step along a path costs one exponential and one square root,
+        and only the first step of a path takes a logarithm.
+
+        The cursor and the carried log-spot are mutable state: a
+        process must not be used by several threads at once.
+
+        The log-spot axis covers the forward drift plus
+        \c stdDevs standard deviations of the ATM black volatility at
+        the exercise date on either side of the spot.
+    */
+    class LocalVolGridProcess : public StochasticProcess1D {
+      public:
+        LocalVolGridProcess(
+            const Date& exercisedate,
+            const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+            const TimeGrid& grid,
+            Size spotNodes = 101,
+            Real stdDevs = 5.0,
+            const boost::shared_ptr<discretization>& d =
+                  boost::shared_ptr<discretization>(new EulerDiscretization));
+
+        Real x0() const;
+        Real drift(Time t, Real x) const;
+        Real diffusion(Time t, Real x) const;
+
+        Real apply(Real x0, Real dx) const;
+        Real evolve(Time t0, Real x0, Time dt, Real dw) const;
+
+        Time time(const Date&) const;
+
+        Rate riskFreeForward() const;
+        Rate dividendForward() const;
+        //! tabulated local volatility, interpolated
+        Volatility localVol(Time t, Real spot) const;
+
+      private:
+        Size row(Time t) const;
+        Volatility lookup(Size row, Real logSpot) const;
+
+        Handle<Quote> x0_;
+        Handle<YieldTermStructure> riskFreeRate_;
+        Rate riskFreeForward_, dividendForward_;
+        std::vector<Time> times_;
+        Real xMin_, dx_, invDx_;
+        Size spotNodes_;
+        // times_.size() rows of spotNodes_ volatilities
+        std::vector<Volatility> table_;
+        mutable Size cursor_;
+        // last spot returned by evolve() and its logarithm
+        mutable Real lastSpot_, lastLogSpot_;
+    };
+
+}
+
+
+#endif
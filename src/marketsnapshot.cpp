@@ -0,0 +1,356 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "./marketsnapshot.hpp"
+#include <ql/termstructures/yield/zerocurve.hpp>
+#include <ql/termstructures/yield/flatforward.hpp>
+#include <ql/termstructures/volatility/equityfx/blackvariancecurve.hpp>
+#include <ql/termstructures/volatility/equityfx/blackconstantvol.hpp>
+#include <ql/time/calendars/nullcalendar.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <math.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace QuantLib {
+
+    namespace {
+
+        const char snapshotMagic[8] = { 'Q','L','C','S','N','A','P','\0' };
+        const boost::uint32_t snapshotVersion = 1;
+
+        bool earlierBucket(const SnapshotBucket& b, Time t) {
+            return b.maturity < t;
+        }
+
+        // [first, first+count) within [0, total), without wrapping
+        bool inRange(boost::uint32_t first, boost::uint32_t count,
+                     boost::uint32_t total) {
+            return first <= total && count <= total - first;
+        }
+
+    }
+
+    MarketSnapshotWriter::MarketSnapshotWriter(const Date& referenceDate)
+    : referenceDate_(referenceDate) {}
+
+    void MarketSnapshotWriter::add(const std::string& name,
+                                   Real spot,
+                                   const std::vector<Date>& riskFreeDates,
+                                   const std::vector<Rate>& riskFreeRates,
+                                   const std::vector<Date>& dividendDates,
+                                   const std::vector<Rate>& dividendRates,
+                                   const std::vector<Date>& volDates,
+                                   const std::vector<Volatility>& vols,
+                                   const std::vector<Date>& bucketDates) {
+        QL_REQUIRE(name.size() < sizeof(SnapshotUnderlying().name),
+                   "underlying name too long: " << name);
+        QL_REQUIRE(riskFreeDates.size() == riskFreeRates.size(),
+                   "risk-free dates/rates mismatch");
+        QL_REQUIRE(dividendDates.size() == dividendRates.size(),
+                   "dividend dates/rates mismatch");
+        QL_REQUIRE(volDates.size() == vols.size(),
+                   "volatility dates/values mismatch");
+        QL_REQUIRE(!riskFreeDates.empty() &&
+                   riskFreeDates.front() == referenceDate_,
+                   "risk-free curve must start at the reference date");
+        QL_REQUIRE(!dividendDates.empty() &&
+                   dividendDates.front() == referenceDate_,
+                   "dividend curve must start at the reference date");
+
+        SnapshotUnderlying u;
+        std::memset(&u, 0, sizeof(SnapshotUnderlying));
+        std::strncpy(u.name, name.c_str(), sizeof(u.name)-1);
+        u.spot = spot;
+
+        u.riskFreeFirst = nodes_.size();
+        u.riskFreeCount = riskFreeDates.size();
+        for (Size i=0; i<riskFreeDates.size(); ++i) {
+            SnapshotNode node = { static_cast<boost::int32_t>(
+                                      riskFreeDates[i].serialNumber()),
+                                  0, riskFreeRates[i] };
+            nodes_.push_back(node);
+        }
+        u.dividendFirst = nodes_.size();
+        u.dividendCount = dividendDates.size();
+        for (Size i=0; i<dividendDates.size(); ++i) {
+            SnapshotNode node = { static_cast<boost::int32_t>(
+                                      dividendDates[i].serialNumber()),
+                                  0, dividendRates[i] };
+            nodes_.push_back(node);
+        }
+        u.volFirst = nodes_.size();
+        u.volCount = volDates.size();
+        for (Size i=0; i<volDates.size(); ++i) {
+            SnapshotNode node = { static_cast<boost::int32_t>(
+                                      volDates[i].serialNumber()),
+                                  0, vols[i] };
+            nodes_.push_back(node);
+        }
+
+        // frozen values, computed once here instead of in every worker
+        u.bucketFirst = buckets_.size();
+        u.bucketCount = bucketDates.size();
+        if (!bucketDates.empty()) {
+            DayCounter dayCounter = Actual365Fixed();
+            ZeroCurve riskFreeTS(riskFreeDates, riskFreeRates, dayCounter);
+            ZeroCurve dividendTS(dividendDates, dividendRates, dayCounter);
+            BlackVarianceCurve volTS(referenceDate_, volDates, vols,
+                                     dayCounter);
+            std::vector<Date> dates(bucketDates);
+            std::sort(dates.begin(), dates.end());
+            for (Size i=0; i<dates.size(); ++i) {
+                Time t = dayCounter.yearFraction(referenceDate_, dates[i]);
+                SnapshotBucket bucket;
+                bucket.maturity = t;
+                bucket.riskFreeForward =
+                    riskFreeTS.zeroRate(t, Continuous, NoFrequency, true);
+                bucket.dividendForward =
+                    dividendTS.zeroRate(t, Continuous, NoFrequency, true);
+                bucket.volatility = volTS.blackVol(t, spot, true);
+                buckets_.push_back(bucket);
+            }
+        }
+
+        underlyings_.push_back(u);
+    }
+
+    void MarketSnapshotWriter::write(const std::string& path) const {
+        SnapshotHeader header;
+        std::memset(&header, 0, sizeof(SnapshotHeader));
+        std::memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+        header.version = snapshotVersion;
+        header.underlyings = underlyings_.size();
+        header.referenceDate = referenceDate_.serialNumber();
+        header.nodes = nodes_.size();
+        header.buckets = buckets_.size();
+
+        FILE* out = std::fopen(path.c_str(), "wb");
+        QL_REQUIRE(out, "cannot open " << path);
+        bool ok = std::fwrite(&header, sizeof(SnapshotHeader), 1, out) == 1;
+        if (ok && !underlyings_.empty())
+            ok = std::fwrite(&underlyings_[0], sizeof(SnapshotUnderlying),
+                             underlyings_.size(), out) == underlyings_.size();
+        if (ok && !nodes_.empty())
+            ok = std::fwrite(&nodes_[0], sizeof(SnapshotNode),
+                             nodes_.size(), out) == nodes_.size();
+        if (ok && !buckets_.empty())
+            ok = std::fwrite(&buckets_[0], sizeof(SnapshotBucket),
+                             buckets_.size(), out) == buckets_.size();
+        ok = (std::fclose(out) == 0) && ok;
+        QL_REQUIRE(ok, "error writing " << path);
+    }
+
+
+    MarketSnapshot::MarketSnapshot(const std::string& path)
+    : data_(0), length_(0) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        QL_REQUIRE(fd >= 0, "cannot open " << path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            QL_FAIL("cannot stat " << path);
+        }
+        length_ = st.st_size;
+        if (length_ < sizeof(SnapshotHeader)) {
+            ::close(fd);
+            QL_FAIL(path << " is not a market snapshot");
+        }
+        data_ = ::mmap(0, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        QL_REQUIRE(data_ != MAP_FAILED, "cannot map " << path);
+
+        const char* base = static_cast<const char*>(data_);
+        header_ = reinterpret_cast<const SnapshotHeader*>(base);
+        underlyings_ = reinterpret_cast<const SnapshotUnderlying*>(
+                                           base + sizeof(SnapshotHeader));
+        nodes_ = reinterpret_cast<const SnapshotNode*>(
+                                           underlyings_ + header_->underlyings);
+        buckets_ = reinterpret_cast<const SnapshotBucket*>(
+                                           nodes_ + header_->nodes);
+
+        std::string error;
+        if (std::memcmp(header_->magic, snapshotMagic,
+                        sizeof(snapshotMagic)) != 0) {
+            error = "not a market snapshot";
+        } else if (header_->version != snapshotVersion) {
+            error = "unsupported snapshot version";
+        } else if (length_ != sizeof(SnapshotHeader)
+                   + header_->underlyings*sizeof(SnapshotUnderlying)
+                   + header_->nodes*sizeof(SnapshotNode)
+                   + header_->buckets*sizeof(SnapshotBucket)) {
+            error = "truncated or corrupted snapshot";
+        } else {
+            for (Size i=0; i<header_->underlyings && error.empty(); ++i) {
+                const SnapshotUnderlying& u = underlyings_[i];
+                if (!inRange(u.riskFreeFirst, u.riskFreeCount,
+                             header_->nodes) ||
+                    !inRange(u.dividendFirst, u.dividendCount,
+                             header_->nodes) ||
+                    !inRange(u.volFirst, u.volCount, header_->nodes) ||
+                    !inRange(u.bucketFirst, u.bucketCount,
+                             header_->buckets))
+                    error = "node or bucket index out of range";
+            }
+        }
+        if (!error.empty()) {
+            ::munmap(data_, length_);
+            QL_FAIL(path << ": " << error);
+        }
+    }
+
+    MarketSnapshot::~MarketSnapshot() {
+        ::munmap(data_, length_);
+    }
+
+    Date MarketSnapshot::referenceDate() const {
+        return Date(static_cast<BigInteger>(header_->referenceDate));
+    }
+
+    Size MarketSnapshot::size() const {
+        return header_->underlyings;
+    }
+
+    const SnapshotUnderlying& MarketSnapshot::underlying(Size i) const {
+        QL_REQUIRE(i < header_->underlyings,
+                   "underlying index (" << i << ") out of range");
+        return underlyings_[i];
+    }
+
+    std::string MarketSnapshot::name(Size i) const {
+        const char* n = underlying(i).name;
+        return std::string(n, strnlen(n, sizeof(underlyings_[0].name)));
+    }
+
+    Size MarketSnapshot::find(const std::string& name) const {
+        for (Size i=0; i<header_->underlyings; ++i)
+            if (this->name(i) == name)
+                return i;
+        QL_FAIL("underlying " << name << " not in snapshot");
+    }
+
+    Real MarketSnapshot::spot(Size i) const {
+        return underlying(i).spot;
+    }
+
+    void MarketSnapshot::frozen(Size i, Time t,
+                                Rate& riskFreeForward,
+                                Rate& dividendForward,
+                                Volatility& volatility) const {
+        const SnapshotUnderlying& u = underlying(i);
+        QL_REQUIRE(u.bucketCount > 0,
+                   "no frozen buckets for " << name(i));
+        const SnapshotBucket* first = buckets_ + u.bucketFirst;
+        const SnapshotBucket* last = first + u.bucketCount;
+        const SnapshotBucket* next =
+            std::lower_bound(first, last, t, earlierBucket);
+
+        if (next == first || next == last) {
+            const SnapshotBucket& b = (next == first ? *first : *(last-1));
+            riskFreeForward = b.riskFreeForward;
+            dividendForward = b.dividendForward;
+            volatility = b.volatility;
+            return;
+        }
+        const SnapshotBucket& b0 = *(next-1);
+        const SnapshotBucket& b1 = *next;
+        Real w = (t - b0.maturity) / (b1.maturity - b0.maturity);
+        riskFreeForward = b0.riskFreeForward
+                        + w*(b1.riskFreeForward - b0.riskFreeForward);
+        dividendForward = b0.dividendForward
+                        + w*(b1.dividendForward - b0.dividendForward);
+        Real v0 = b0.volatility*b0.volatility*b0.maturity;
+        Real v1 = b1.volatility*b1.volatility*b1.maturity;
+        volatility = std::sqrt((v0 + w*(v1-v0))/t);
+    }
+
+    boost::shared_ptr<BlackScholesConstProcess>
+    MarketSnapshot::constProcess(Size i, Time t) const {
+        Rate r, q;
+        Volatility sigma;
+        frozen(i, t, r, q, sigma);
+        Handle<Quote> x0(boost::shared_ptr<Quote>(new SimpleQuote(spot(i))));
+        return boost::shared_ptr<BlackScholesConstProcess>(
+                             new BlackScholesConstProcess(x0, r, q, sigma));
+    }
+
+    boost::shared_ptr<GeneralizedBlackScholesProcess>
+    MarketSnapshot::process(Size i, Time t) const {
+        Rate r, q;
+        Volatility sigma;
+        frozen(i, t, r, q, sigma);
+        Date today = referenceDate();
+        DayCounter dayCounter = Actual365Fixed();
+        Handle<Quote> x0(boost::shared_ptr<Quote>(new SimpleQuote(spot(i))));
+        Handle<YieldTermStructure> riskFreeTS(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(today, r, dayCounter)));
+        Handle<YieldTermStructure> dividendTS(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(today, q, dayCounter)));
+        Handle<BlackVolTermStructure> volTS(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackConstantVol(today, NullCalendar(), sigma,
+                                     dayCounter)));
+        return boost::shared_ptr<GeneralizedBlackScholesProcess>(
+            new BlackScholesMertonProcess(x0, dividendTS, riskFreeTS, volTS));
+    }
+
+    void MarketSnapshot::nodes(boost::uint32_t first,
+                               boost::uint32_t count,
+                               std::vector<Date>& dates,
+                               std::vector<Real>& values) const {
+        dates.resize(count);
+        values.resize(count);
+        for (Size j=0; j<count; ++j) {
+            dates[j] = Date(static_cast<BigInteger>(nodes_[first+j].date));
+            values[j] = nodes_[first+j].value;
+        }
+    }
+
+    Handle<YieldTermStructure> MarketSnapshot::riskFreeCurve(Size i) const {
+        const SnapshotUnderlying& u = underlying(i);
+        std::vector<Date> dates;
+        std::vector<Real> rates;
+        nodes(u.riskFreeFirst, u.riskFreeCount, dates, rates);
+        return Handle<YieldTermStructure>(
+            boost::shared_ptr<YieldTermStructure>(
+                new ZeroCurve(dates, rates, Actual365Fixed())));
+    }
+
+    Handle<YieldTermStructure> MarketSnapshot::dividendCurve(Size i) const {
+        const SnapshotUnderlying& u = underlying(i);
+        std::vector<Date> dates;
+        std::vector<Real> rates;
+        nodes(u.dividendFirst, u.dividendCount, dates, rates);
+        return Handle<YieldTermStructure>(
+            boost::shared_ptr<YieldTermStructure>(
+                new ZeroCurve(dates, rates, Actual365Fixed())));
+    }
+
+    Handle<BlackVolTermStructure>
+    MarketSnapshot::volatilityCurve(Size i) const {
+        const SnapshotUnderlying& u = underlying(i);
+        std::vector<Date> dates;
+        std::vector<Real> vols;
+        nodes(u.volFirst, u.volCount, dates, vols);
+        return Handle<BlackVolTermStructure>(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackVarianceCurve(referenceDate(), dates, vols,
+                                       Actual365Fixed())));
+    }
+
+}
@@ -0,0 +1,162 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file marketsnapshot.hpp
+    \brief memory-mapped binary market snapshot for the const engines
+*/
+
+#ifndef quantlib_market_snapshot_hpp
+#define quantlib_market_snapshot_hpp
+
+#include <ql/processes/blackscholesprocess.hpp>
+#include <ql/time/date.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include "./blackscholesconstprocess.hpp"
+#include <string>
+#include <vector>
+
+namespace QuantLib {
+
+    /* On-disk layout, native byte order, every record a multiple of
+       8 bytes so that the mapped arrays are aligned:
+
+           SnapshotHeader
+           SnapshotUnderlying[underlyings]
+           SnapshotNode[nodes]       curve and volatility nodes
+           SnapshotBucket[buckets]   frozen r/q/sigma per maturity
+
+       Node dates are QuantLib serial numbers; zero rates are
+       continuous Actual/365 (Fixed), and bucket maturities are year
+       fractions from the reference date on the same day counter. */
+
+    struct SnapshotHeader {
+        char magic[8];
+        boost::uint32_t version;
+        boost::uint32_t underlyings;
+        boost::int32_t referenceDate;
+        boost::uint32_t nodes;
+        boost::uint32_t buckets;
+        boost::uint32_t reserved;
+    };
+
+    struct SnapshotUnderlying {
+        char name[24];
+        double spot;
+        boost::uint32_t riskFreeFirst, riskFreeCount;
+        boost::uint32_t dividendFirst, dividendCount;
+        boost::uint32_t volFirst, volCount;
+        boost::uint32_t bucketFirst, bucketCount;
+    };
+
+    struct SnapshotNode {
+        boost::int32_t date;
+        boost::uint32_t reserved;
+        double value;
+    };
+
+    struct SnapshotBucket {
+        double maturity;
+        double riskFreeForward;
+        double dividendForward;
+        double volatility;
+    };
+
+
+    //! builds a snapshot file from curve and volatility nodes
+    /*! The curves are bootstrapped once here, with the same
+        interpolations the reader uses, and the frozen r, q and sigma
+        are computed for each bucket date exactly as
+        BlackScholesConstProcess would (zero rates and ATM-spot black
+        volatility at the bucket time).
+    */
+    class MarketSnapshotWriter {
+      public:
+        explicit MarketSnapshotWriter(const Date& referenceDate);
+
+        /*! riskFreeDates and dividendDates must start at the reference
+            date; volDates must be after it. */
+        void add(const std::string& name,
+                 Real spot,
+                 const std::vector<Date>& riskFreeDates,
+                 const std::vector<Rate>& riskFreeRates,
+                 const std::vector<Date>& dividendDates,
+                 const std::vector<Rate>& dividendRates,
+                 const std::vector<Date>& volDates,
+                 const std::vector<Volatility>& vols,
+                 const std::vector<Date>& bucketDates = std::vector<Date>());
+
+        void write(const std::string& path) const;
+
+      private:
+        Date referenceDate_;
+        std::vector<SnapshotUnderlying> underlyings_;
+        std::vector<SnapshotNode> nodes_;
+        std::vector<SnapshotBucket> buckets_;
+    };
+
+
+    //! read-only view of a memory-mapped snapshot
+    /*! The file is mapped once and never copied; the accessors read the
+        mapped records directly. constProcess() builds a
+        BlackScholesConstProcess from the frozen buckets without any
+        term structure, and process() returns a Black-Scholes process on
+        flat curves at the frozen values, which is what the const
+        engines need and costs no bootstrapping. The full curves can
+        still be rebuilt from the nodes with riskFreeCurve(),
+        dividendCurve() and volatilityCurve().
+    */
+    class MarketSnapshot : private boost::noncopyable {
+      public:
+        explicit MarketSnapshot(const std::string& path);
+        ~MarketSnapshot();
+
+        Date referenceDate() const;
+        Size size() const;
+        std::string name(Size i) const;
+        //! index of the named underlying
+        Size find(const std::string& name) const;
+        Real spot(Size i) const;
+
+        //! frozen values at time t, interpolated between buckets
+        /*! r and q are linear in t, sigma is linear in total variance;
+            values are flat outside the bucket range. */
+        void frozen(Size i, Time t,
+                    Rate& riskFreeForward,
+                    Rate& dividendForward,
+                    Volatility& volatility) const;
+
+        boost::shared_ptr<BlackScholesConstProcess> constProcess(
+                                                Size i, Time t) const;
+        boost::shared_ptr<GeneralizedBlackScholesProcess> process(
+                                                Size i, Time t) const;
+
+        Handle<YieldTermStructure> riskFreeCurve(Size i) const;
+        Handle<YieldTermStructure> dividendCurve(Size i) const;
+        Handle<BlackVolTermStructure> volatilityCurve(Size i) const;
+
+      private:
+        const SnapshotUnderlying& underlying(Size i) const;
+        void nodes(boost::uint32_t first, boost::uint32_t count,
+                   std::vector<Date>& dates,
+                   std::vector<Real>& values) const;
+
+        void* data_;
+        std::size_t length_;
+        const SnapshotHeader* header_;
+        const SnapshotUnderlying* underlyings_;
+        const SnapshotNode* nodes_;
+        const SnapshotBucket* buckets_;
+    };
+
+}
+
+
+#endif
@@ -18,6 +18,10 @@
 #include <ql/pricingengines/asian/mc_discr_geom_av_price.hpp>
 #include <ql/pricingengines/asian/analytic_discr_geom_av_price.hpp>
 #include <ql/exercise.hpp>
+#include "./localvolgridprocess.hpp"
+#include "./constresultcache.hpp"
+#include "./constsimulationcontext.hpp"
+#include <typeinfo>
 
 namespace QuantLib {
 
@@ -55,7 +59,10 @@ namespace QuantLib {
              Real requiredTolerance,
              Size maxSamples,
              BigNatural seed,
-             bool ifConst) : MCDiscreteArithmeticAPEngine<RNG,S>(process,
+             bool ifConst,
+             bool localVolGrid = false,
+             const boost::shared_ptr<ConstResultCache>& cache =
+                    boost::shared_ptr<ConstResultCache>()) : MCDiscreteArithmeticAPEngine<RNG,S>(process,
                                             brownianBridge,
                                             antitheticVariate,
                                             controlVariate,
@@ -66,29 +73,170 @@ namespace QuantLib {
                                             realProcess(process),
                                             ifconst(ifConst),
                                             seed_(seed),
-                                            brownianBridge_(brownianBridge){};
+                                            brownianBridge_(brownianBridge),
+                                            localVolGrid_(localVolGrid),
+                                            cache_(cache),
+                                            lastRunToppedUp_(false),
+                                            context_(seed, brownianBridge){};
+
+        /* As in MCEuropeanConstEngine, only results that depend on the
+           key alone are cached, and the Monte Carlo model is kept for a
+           top-up when the inputs have not changed; the control variate
+           is priced on the real curves, so it disables both. */
+        void calculate() const {
+            lastRunToppedUp_ = false;
+            bool frozen = ifconst && !localVolGrid_ && !this->controlVariate_;
+            bool cacheable = cache_ && frozen &&
+                             (seed_ != 0 || !RNG::allowsErrorEstimate);
+            if (!frozen) {
+                lastInputKey_.reset();
+                MCDiscreteArithmeticAPEngine<RNG,S>::calculate();
+                return;
+            }
+            ConstResultCache::Key inputs = inputKey();
+            ConstResultCache::Key key = cacheKey(inputs);
+            if (cacheable && cache_->find(key, this->results_.value,
+                                          this->results_.errorEstimate)) {
+                lastRunToppedUp_ = true;
+                return;
+            }
+
+            if (canTopUp(inputs)) {
+                lastRunToppedUp_ = true;
+                if (this->requiredTolerance_ != Null<Real>())
+                    this->value(this->requiredTolerance_,
+                                this->maxSamples_ == Null<Size>() ?
+                                QL_MAX_INTEGER : this->maxSamples_);
+                else
+                    this->valueWithSamples(this->requiredSamples_);
+                this->results_.value =
+                    this->mcModel_->sampleAccumulator().mean();
+                if (RNG::allowsErrorEstimate)
+                    this->results_.errorEstimate =
+                        this->mcModel_->sampleAccumulator().errorEstimate();
+            } else {
+                lastInputKey_.reset();
+                MCDiscreteArithmeticAPEngine<RNG,S>::calculate();
+                lastInputKey_ = boost::shared_ptr<ConstResultCache::Key>(
+                                           new ConstResultCache::Key(inputs));
+            }
+
+            if (cacheable)
+                cache_->insert(key, this->results_.value,
+                               this->results_.errorEstimate);
+        }
+
+        //! whether the last run only added paths to, or reused, earlier ones
+        bool lastRunToppedUp() const { return lastRunToppedUp_; }
+
+        //! starts the paths at the n-th sequence of the seed's stream
+        void setFirstSample(Size n) {
+            QL_REQUIRE(ifconst && !localVolGrid_,
+                       "sample offset requires constant parameters");
+            // if the last run stopped at the n-th sequence, the context
+            // goes on from there instead of skipping from the seed
+            Size drawn = this->mcModel_ ?
+                this->mcModel_->sampleAccumulator().samples() : 0;
+            context_.setFirstSample(n, drawn);
+            this->update();
+        }
+
+        //! asks for more samples; the next run tops up if it can
+        void setRequiredSamples(Size samples) {
+            this->requiredTolerance_ = Null<Real>();
+            this->requiredSamples_ = samples;
+            this->update();
+        }
+
+        //! asks for a tolerance; the next run tops up if it can
+        void setRequiredTolerance(Real tolerance) {
+            QL_REQUIRE(RNG::allowsErrorEstimate,
+                       "chosen random generator policy "
+                       "does not allow an error estimate");
+            this->requiredSamples_ = Null<Size>();
+            this->requiredTolerance_ = tolerance;
+            this->update();
+        }
 
       protected:
-        // McSimulation implementation
-        boost::shared_ptr<path_generator_type> pathGenerator() const {
-            if(ifconst){
-                Date exercisedate = GenericEngine<DiscreteAveragingAsianOption::arguments,DiscreteAveragingAsianOption::results>::arguments_.exercise->lastDate(); 
-                boost::shared_ptr<BlackScholesConstProcess> constProcess_(
+        boost::shared_ptr<BlackScholesConstProcess> constProcess() const {
+            Date exercisedate = GenericEngine<DiscreteAveragingAsianOption::arguments,DiscreteAveragingAsianOption::results>::arguments_.exercise->lastDate();
+            return boost::shared_ptr<BlackScholesConstProcess>(
                 new BlackScholesConstProcess(
                     exercisedate,
                     realProcess->stateVariable(),
                     realProcess->dividendYield(),
                     realProcess->riskFreeRate(),
-                    realProcess->blackVolatility()                                              
+                    realProcess->blackVolatility()
                 ));
-                
+        }
+
+        bool canTopUp(const ConstResultCache::Key& inputs) const {
+            if (!this->mcModel_ || !lastInputKey_ ||
+                !(*lastInputKey_ == inputs))
+                return false;
+            return this->requiredTolerance_ != Null<Real>() ||
+                   this->requiredSamples_ >=
+                   this->mcModel_->sampleAccumulator().samples();
+        }
+
+        // everything the price depends on but the sample settings
+        ConstResultCache::Key inputKey() const {
+            const DiscreteAveragingAsianOption::arguments& args =
+                GenericEngine<DiscreteAveragingAsianOption::arguments,DiscreteAveragingAsianOption::results>::arguments_;
+            boost::shared_ptr<StrikedTypePayoff> payoff =
+                boost::dynamic_pointer_cast<StrikedTypePayoff>(args.payoff);
+            QL_REQUIRE(payoff, "non-striked payoff given");
+            boost::shared_ptr<BlackScholesConstProcess> constProcess_ =
+                constProcess();
+            TimeGrid grid = this->timeGrid();
+
+            ConstResultCache::Key key(
+                std::string("MCDiscreteArithmeticAPConstEngine/")
+                + typeid(RNG).name() + "/" + payoff->name());
+            key << constProcess_->x0()
+                << constProcess_->riskFreeForward()
+                << constProcess_->dividendForward()
+                << constProcess_->diffusion()
+                << Real(payoff->optionType()) << payoff->strike()
+                << Real(args.averageType)
+                << args.runningAccumulator << Real(args.pastFixings)
+                << Real(seed_)
+                << Real(this->antitheticVariate_)
+                << Real(brownianBridge_)
+                << Real(context_.firstSample())
+                << Real(grid.size());
+            for (Size i=0; i<grid.size(); ++i)
+                key << grid[i];
+            return key;
+        }
+
+        ConstResultCache::Key cacheKey(
+                                 const ConstResultCache::Key& inputs) const {
+            ConstResultCache::Key key = inputs;
+            key << Real(this->requiredSamples_)
+                << this->requiredTolerance_
+                << Real(this->maxSamples_);
+            return key;
+        }
+
+        // McSimulation implementation
+        boost::shared_ptr<path_generator_type> pathGenerator() const {
+            if(localVolGrid_){
+                Date exercisedate = GenericEngine<DiscreteAveragingAsianOption::arguments,DiscreteAveragingAsianOption::results>::arguments_.exercise->lastDate();
                 TimeGrid grid = this->timeGrid();
+                boost::shared_ptr<LocalVolGridProcess> gridProcess_(
+                    new LocalVolGridProcess(exercisedate, realProcess, grid));
                 typename RNG::rsg_type gen =
                     RNG::make_sequence_generator(grid.size()-1,seed_);
                 return boost::shared_ptr<path_generator_type>(
-                        new path_generator_type(constProcess_, grid,
+                        new path_generator_type(gridProcess_, grid,
                                        gen, brownianBridge_));
-                    
+            }else if(ifconst){
+                // grid, generator and bridge are kept between runs
+                Date exercisedate = GenericEngine<DiscreteAveragingAsianOption::arguments,DiscreteAveragingAsianOption::results>::arguments_.exercise->lastDate();
+                return context_.pathGenerator(realProcess, exercisedate,
+                                              this->timeGrid());
             }else{
                 return MCDiscreteArithmeticAPEngine<RNG,S>::pathGenerator();
             }
@@ -99,6 +247,11 @@ namespace QuantLib {
         boost::shared_ptr<GeneralizedBlackScholesProcess> realProcess;
         BigNatural seed_;
         bool brownianBridge_;
+        bool localVolGrid_;
+        boost::shared_ptr<ConstResultCache> cache_;
+        mutable boost::shared_ptr<ConstResultCache::Key> lastInputKey_;
+        mutable bool lastRunToppedUp_;
+        mutable ConstSimulationContext<RNG,path_generator_type> context_;
     };
 
     template <class RNG = PseudoRandom, class S = Statistics>
@@ -114,6 +267,9 @@ namespace QuantLib {
         MakeMCDiscreteArithmeticAPConstEngine& withSeed(BigNatural seed);
         MakeMCDiscreteArithmeticAPConstEngine& withAntitheticVariate(bool b = true);
         MakeMCDiscreteArithmeticAPConstEngine& withControlVariate(bool b = true);
+        MakeMCDiscreteArithmeticAPConstEngine& withLocalVolGrid(bool b = true);
+        MakeMCDiscreteArithmeticAPConstEngine& withResultCache(
+                        const boost::shared_ptr<ConstResultCache>& cache);
         // conversion to pricing engine
         operator boost::shared_ptr<PricingEngine>() const;
       private:
@@ -124,6 +280,8 @@ namespace QuantLib {
         bool brownianBridge_;
         BigNatural seed_;
         bool ifconst;
+        bool localVolGrid_;
+        boost::shared_ptr<ConstResultCache> cache_;
     };
 
     template <class RNG, class S>
@@ -132,7 +290,8 @@ namespace QuantLib {
              const boost::shared_ptr<GeneralizedBlackScholesProcess>& process, bool ifConst)
     : process_(process), antithetic_(false), controlVariate_(false),
       samples_(Null<Size>()), maxSamples_(Null<Size>()),
-      tolerance_(Null<Real>()), brownianBridge_(true), seed_(0), ifconst(ifConst) {}
+      tolerance_(Null<Real>()), brownianBridge_(true), seed_(0), ifconst(ifConst),
+      localVolGrid_(false) {}
 
     template <class RNG, class S>
     inline MakeMCDiscreteArithmeticAPConstEngine<RNG,S>&
@@ -191,6 +350,21 @@ namespace QuantLib {
         return *this;
     }
 
+    template <class RNG, class S>
+    inline MakeMCDiscreteArithmeticAPConstEngine<RNG,S>&
+    MakeMCDiscreteArithmeticAPConstEngine<RNG,S>::withLocalVolGrid(bool b) {
+        localVolGrid_ = b;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCDiscreteArithmeticAPConstEngine<RNG,S>&
+    MakeMCDiscreteArithmeticAPConstEngine<RNG,S>::withResultCache(
+                        const boost::shared_ptr<ConstResultCache>& cache) {
+        cache_ = cache;
+        return *this;
+    }
+
     template <class RNG, class S>
     inline
     MakeMCDiscreteArithmeticAPConstEngine<RNG,S>::operator boost::shared_ptr<PricingEngine>()
@@ -202,7 +376,9 @@ namespace QuantLib {
                                                 samples_, tolerance_,
                                                 maxSamples_,
                                                 seed_,
-                                                ifconst));
+                                                ifconst,
+                                                localVolGrid_,
+                                                cache_));
     }
 
 
@@ -0,0 +1,455 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file mcamericanconstengine.hpp
+    \brief Longstaff-Schwartz American engine with const parameters
+*/
+
+#ifndef quantlib_montecarlo_american_const_engine_hpp
+#define quantlib_montecarlo_american_const_engine_hpp
+
+#include <ql/pricingengines/vanilla/mcamericanengine.hpp>
+#include <ql/math/matrixutilities/svd.hpp>
+#include "./blackscholesconstprocess.hpp"
+#include <vector>
+
+namespace QuantLib {
+
+    //! Longstaff-Schwartz path pricer on a flat coefficient table
+    /*! Exercise rule fitted by MCAmericanConstEngine: one row of
+        polynomial coefficients (monomials in S/K) per grid step, all
+        stored in one contiguous array and evaluated with Horner's rule.
+        Values are returned discounted to t=0.
+    */
+    class LongstaffSchwartzConstPathPricer : public PathPricer<Path> {
+      public:
+        LongstaffSchwartzConstPathPricer(
+                                Option::Type type,
+                                Real strike,
+                                const std::vector<DiscountFactor>& discounts,
+                                const std::vector<bool>& exercise,
+                                const std::vector<Real>& coefficients,
+                                Size basisSize)
+        : omega_(type == Option::Call ? 1.0 : -1.0), strike_(strike),
+          discounts_(discounts), exercise_(exercise),
+          coefficients_(coefficients), basisSize_(basisSize) {}
+
+        Real operator()(const Path& path) const {
+            Size n = path.length();
+            for (Size i=1; i<n-1; ++i) {
+                if (!exercise_[i])
+                    continue;
+                Real payoff = std::max(omega_*(path[i]-strike_), 0.0);
+                if (payoff <= 0.0)
+                    continue;
+                const Real* beta = &coefficients_[i*basisSize_];
+                Real x = path[i]/strike_;
+                Real continuation = beta[basisSize_-1];
+                for (Size k=basisSize_-1; k>0; --k)
+                    continuation = continuation*x + beta[k-1];
+                if (payoff*discounts_[i] > continuation)
+                    return payoff*discounts_[i];
+            }
+            return std::max(omega_*(path.back()-strike_), 0.0)
+                 * discounts_[n-1];
+        }
+      private:
+        Real omega_, strike_;
+        std::vector<DiscountFactor> discounts_;
+        std::vector<bool> exercise_;
+        std::vector<Real> coefficients_;
+        Size basisSize_;
+    };
+
+
+    //! Monte Carlo American engine with const parameters
+    /*! Same interface as MCAmericanEngine plus the const flag. When
+        ifConst is set, both the calibration and the pricing paths are
+        generated by BlackScholesConstProcess, and the regression is
+        done by the engine itself: calibration paths are copied into a
+        single step-major buffer, and at each exercise date the normal
+        equations for a fixed monomial basis in S/K are accumulated in
+        one pass over the in-the-money paths (the basis buffer is
+        allocated once and reused across dates) and solved by SVD.
+        Without the flag the engine falls back to MCAmericanEngine.
+
+        \warning in the const path the basis is always monomial and
+                 the control variate is not used.
+    */
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MCAmericanConstEngine : public MCAmericanEngine<RNG,S> {
+      public:
+        typedef typename McSimulation<SingleVariate,RNG,S>::path_generator_type
+            path_generator_type;
+        typedef typename McSimulation<SingleVariate,RNG,S>::path_pricer_type
+            path_pricer_type;
+        typedef typename McSimulation<SingleVariate,RNG,S>::stats_type
+            stats_type;
+        // constructor
+        MCAmericanConstEngine(
+             const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+             Size timeSteps,
+             Size timeStepsPerYear,
+             bool antitheticVariate,
+             Size requiredSamples,
+             Real requiredTolerance,
+             Size maxSamples,
+             BigNatural seed,
+             Size polynomOrder,
+             Size nCalibrationSamples,
+             bool ifconst) : MCAmericanEngine<RNG,S>(
+                 process,
+                 timeSteps,
+                 timeStepsPerYear,
+                 antitheticVariate,
+                 false,
+                 requiredSamples,
+                 requiredTolerance,
+                 maxSamples,
+                 seed,
+                 polynomOrder,
+                 LsmBasisSystem::Monomial,
+                 nCalibrationSamples),
+                 ifConst(ifconst),
+                 realProcess(process),
+                 requiredSamples_(requiredSamples),
+                 requiredTolerance_(requiredTolerance),
+                 maxSamples_(maxSamples),
+                 seed_(seed),
+                 polynomOrder_(polynomOrder),
+                 nCalibrationSamples_(nCalibrationSamples == Null<Size>() ?
+                                      2048 : nCalibrationSamples) {};
+
+        void calculate() const {
+            if (!ifConst) {
+                MCAmericanEngine<RNG,S>::calculate();
+                return;
+            }
+
+            this->mcModel_ =
+                boost::shared_ptr<MonteCarloModel<SingleVariate,RNG,S> >(
+                    new MonteCarloModel<SingleVariate,RNG,S>(
+                           pathGenerator(), calibratedPathPricer(),
+                           stats_type(), this->antitheticVariate_));
+
+            if (requiredTolerance_ != Null<Real>()) {
+                if (maxSamples_ != Null<Size>())
+                    this->value(requiredTolerance_, maxSamples_);
+                else
+                    this->value(requiredTolerance_);
+            } else {
+                this->valueWithSamples(requiredSamples_);
+            }
+
+            this->results_.value = this->mcModel_->sampleAccumulator().mean();
+            if (RNG::allowsErrorEstimate)
+                this->results_.errorEstimate =
+                    this->mcModel_->sampleAccumulator().errorEstimate();
+        }
+
+     protected:
+            boost::shared_ptr<path_generator_type> pathGenerator() const {
+                if(ifConst){
+                    return constPathGenerator(seed_);
+                }else{
+                    return MCAmericanEngine<RNG,S>::pathGenerator();
+                }
+            };
+
+            boost::shared_ptr<BlackScholesConstProcess> constProcess() const {
+                Date exercisedate = GenericEngine<OneAssetOption::arguments,OneAssetOption::results>::arguments_.exercise->lastDate();
+                return boost::shared_ptr<BlackScholesConstProcess>(
+                new BlackScholesConstProcess(
+                    exercisedate,
+                    realProcess->stateVariable(),
+                    realProcess->dividendYield(),
+                    realProcess->riskFreeRate(),
+                    realProcess->blackVolatility()
+                ));
+            }
+
+            boost::shared_ptr<path_generator_type> constPathGenerator(
+                                                    BigNatural seed) const {
+                boost::shared_ptr<BlackScholesConstProcess> constProcess_ =
+                    constProcess();
+
+                TimeGrid grid = this->timeGrid();
+                typename RNG::rsg_type generator =
+                    RNG::make_sequence_generator(grid.size()-1,seed);
+                return boost::shared_ptr<path_generator_type>(
+                        new path_generator_type(constProcess_, grid,
+                                       generator, false));
+            }
+
+            // calibration pass: fills a step-major path buffer and
+            // regresses backwards to get the exercise boundary
+            boost::shared_ptr<path_pricer_type> calibratedPathPricer() const {
+                const OneAssetOption::arguments& args =
+                    GenericEngine<OneAssetOption::arguments,OneAssetOption::results>::arguments_;
+                boost::shared_ptr<StrikedTypePayoff> payoff =
+                    boost::dynamic_pointer_cast<StrikedTypePayoff>(args.payoff);
+                QL_REQUIRE(payoff, "non-striked payoff given");
+                Real omega = (payoff->optionType() == Option::Call ? 1.0 : -1.0);
+                Real strike = payoff->strike();
+
+                TimeGrid grid = this->timeGrid();
+                Size steps = grid.size()-1;
+
+                // discount at the rate frozen in the paths' drift
+                Rate r = constProcess()->riskFreeForward();
+                std::vector<DiscountFactor> discounts(grid.size());
+                for (Size i=0; i<grid.size(); ++i)
+                    discounts[i] = std::exp(-r*grid[i]);
+
+                std::vector<bool> exercise(grid.size(), false);
+                if (args.exercise->type() == Exercise::American) {
+                    Time earliest =
+                        realProcess->time(args.exercise->dates().front());
+                    for (Size i=1; i<grid.size(); ++i)
+                        exercise[i] = (grid[i] >= earliest);
+                } else {
+                    for (Size j=0; j<args.exercise->dates().size(); ++j) {
+                        Time t = realProcess->time(args.exercise->date(j));
+                        if (t > 0.0)
+                            exercise[grid.closestIndex(t)] = true;
+                    }
+                }
+
+                // pathBuffer[i*nPaths+j] is the value of path j at step i
+                Size nPaths = nCalibrationSamples_;
+                std::vector<Real> pathBuffer(grid.size()*nPaths);
+                BigNatural calibrationSeed =
+                    (seed_ == 0 ? 0 : seed_ + 1768237423UL);
+                boost::shared_ptr<path_generator_type> generator =
+                    constPathGenerator(calibrationSeed);
+                for (Size j=0; j<nPaths; ++j) {
+                    const Path& path = generator->next().value;
+                    for (Size i=0; i<grid.size(); ++i)
+                        pathBuffer[i*nPaths+j] = path[i];
+                }
+
+                // discounted cash flows under the current exercise rule
+                std::vector<Real> cashFlows(nPaths);
+                for (Size j=0; j<nPaths; ++j)
+                    cashFlows[j] = std::max(
+                                 omega*(pathBuffer[steps*nPaths+j] - strike),
+                                 0.0)
+                                 * discounts[steps];
+
+                Size basisSize = polynomOrder_+1;
+                std::vector<Real> coefficients(grid.size()*basisSize, 0.0);
+                std::vector<bool> regressed(exercise);
+                std::vector<Real> basis(nPaths*basisSize);
+                std::vector<Size> itm(nPaths);
+                Matrix normal(basisSize, basisSize);
+                Array rhs(basisSize);
+
+                for (Size i=steps-1; i>0; --i) {
+                    if (!exercise[i])
+                        continue;
+                    const Real* spot = &pathBuffer[i*nPaths];
+
+                    // basis rows for the in-the-money paths
+                    Size n = 0;
+                    for (Size j=0; j<nPaths; ++j) {
+                        if (omega*(spot[j]-strike) <= 0.0)
+                            continue;
+                        Real* row = &basis[n*basisSize];
+                        Real x = spot[j]/strike;
+                        row[0] = 1.0;
+                        for (Size k=1; k<basisSize; ++k)
+                            row[k] = row[k-1]*x;
+                        itm[n++] = j;
+                    }
+                    if (n < basisSize) {
+                        regressed[i] = false;
+                        continue;
+                    }
+
+                    std::fill(normal.begin(), normal.end(), 0.0);
+                    std::fill(rhs.begin(), rhs.end(), 0.0);
+                    for (Size m=0; m<n; ++m) {
+                        const Real* row = &basis[m*basisSize];
+                        Real y = cashFlows[itm[m]];
+                        for (Size k=0; k<basisSize; ++k) {
+                            rhs[k] += row[k]*y;
+                            for (Size l=0; l<=k; ++l)
+                                normal[k][l] += row[k]*row[l];
+                        }
+                    }
+                    for (Size k=0; k<basisSize; ++k)
+                        for (Size l=k+1; l<basisSize; ++l)
+                            normal[k][l] = normal[l][k];
+
+                    Array beta = SVD(normal).solveFor(rhs);
+                    std::copy(beta.begin(), beta.end(),
+                              coefficients.begin()+i*basisSize);
+
+                    // update the exercise decision on the same paths
+                    for (Size m=0; m<n; ++m) {
+                        const Real* row = &basis[m*basisSize];
+                        Real continuation = 0.0;
+                        for (Size k=0; k<basisSize; ++k)
+                            continuation += beta[k]*row[k];
+                        Real exerciseValue =
+                            omega*(spot[itm[m]]-strike) * discounts[i];
+                        if (exerciseValue > continuation)
+                            cashFlows[itm[m]] = exerciseValue;
+                    }
+                }
+
+                return boost::shared_ptr<path_pricer_type>(
+                    new LongstaffSchwartzConstPathPricer(
+                        payoff->optionType(), strike, discounts,
+                        regressed, coefficients, basisSize));
+            }
+
+            bool ifConst;
+            boost::shared_ptr<GeneralizedBlackScholesProcess> realProcess;
+            Size requiredSamples_;
+            Real requiredTolerance_;
+            Size maxSamples_;
+            BigNatural seed_;
+            Size polynomOrder_, nCalibrationSamples_;
+    };
+
+    //! Monte Carlo American const engine factory
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MakeMCAmericanConstEngine {
+      public:
+        MakeMCAmericanConstEngine(
+                    const boost::shared_ptr<GeneralizedBlackScholesProcess>&, bool ifconst);
+        // named parameters
+        MakeMCAmericanConstEngine& withSteps(Size steps);
+        MakeMCAmericanConstEngine& withStepsPerYear(Size steps);
+        MakeMCAmericanConstEngine& withSamples(Size samples);
+        MakeMCAmericanConstEngine& withAbsoluteTolerance(Real tolerance);
+        MakeMCAmericanConstEngine& withMaxSamples(Size samples);
+        MakeMCAmericanConstEngine& withSeed(BigNatural seed);
+        MakeMCAmericanConstEngine& withAntitheticVariate(bool b = true);
+        MakeMCAmericanConstEngine& withPolynomOrder(Size polynomOrder);
+        MakeMCAmericanConstEngine& withCalibrationSamples(Size samples);
+
+        // conversion to pricing engine
+        operator boost::shared_ptr<PricingEngine>() const;
+      private:
+        boost::shared_ptr<GeneralizedBlackScholesProcess> process_;
+        bool antithetic_;
+        Size steps_, stepsPerYear_, samples_, maxSamples_, calibrationSamples_;
+        Real tolerance_;
+        BigNatural seed_;
+        Size polynomOrder_;
+        bool ifConst_;
+    };
+
+    template <class RNG, class S>
+    inline MakeMCAmericanConstEngine<RNG,S>::MakeMCAmericanConstEngine(
+             const boost::shared_ptr<GeneralizedBlackScholesProcess>& process, bool ifconst)
+    : process_(process), antithetic_(false),
+      steps_(Null<Size>()), stepsPerYear_(Null<Size>()),
+      samples_(Null<Size>()), maxSamples_(Null<Size>()),
+      calibrationSamples_(2048), tolerance_(Null<Real>()), seed_(0),
+      polynomOrder_(2), ifConst_(ifconst) {}
+
+    template <class RNG, class S>
+    inline MakeMCAmericanConstEngine<RNG,S>&
+    MakeMCAmericanConstEngine<RNG,S>::withSteps(Size steps) {
+        steps_ = steps;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCAmericanConstEngine<RNG,S>&
+    MakeMCAmericanConstEngine<RNG,S>::withStepsPerYear(Size steps) {
+        stepsPerYear_ = steps;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCAmericanConstEngine<RNG,S>&
+    MakeMCAmericanConstEngine<RNG,S>::withSamples(Size samples) {
+        QL_REQUIRE(tolerance_ == Null<Real>(),
+                   "tolerance already set");
+        samples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCAmericanConstEngine<RNG,S>&
+    MakeMCAmericanConstEngine<RNG,S>::withAbsoluteTolerance(Real tolerance) {
+        QL_REQUIRE(samples_ == Null<Size>(),
+                   "number of samples already set");
+        QL_REQUIRE(RNG::allowsErrorEstimate,
+                   "chosen random generator policy "
+                   "does not allow an error estimate");
+        tolerance_ = tolerance;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCAmericanConstEngine<RNG,S>&
+    MakeMCAmericanConstEngine<RNG,S>::withMaxSamples(Size samples) {
+        maxSamples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCAmericanConstEngine<RNG,S>&
+    MakeMCAmericanConstEngine<RNG,S>::withSeed(BigNatural seed) {
+        seed_ = seed;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCAmericanConstEngine<RNG,S>&
+    MakeMCAmericanConstEngine<RNG,S>::withAntitheticVariate(bool b) {
+        antithetic_ = b;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCAmericanConstEngine<RNG,S>&
+    MakeMCAmericanConstEngine<RNG,S>::withPolynomOrder(Size polynomOrder) {
+        polynomOrder_ = polynomOrder;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCAmericanConstEngine<RNG,S>&
+    MakeMCAmericanConstEngine<RNG,S>::withCalibrationSamples(Size samples) {
+        calibrationSamples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline
+    MakeMCAmericanConstEngine<RNG,S>::operator boost::shared_ptr<PricingEngine>()
+                                                                      const {
+        QL_REQUIRE(steps_ != Null<Size>() || stepsPerYear_ != Null<Size>(),
+                   "number of steps not given");
+        QL_REQUIRE(steps_ == Null<Size>() || stepsPerYear_ == Null<Size>(),
+                   "number of steps overspecified");
+        return boost::shared_ptr<PricingEngine>(new
+            MCAmericanConstEngine<RNG,S>(process_,
+                                    steps_,
+                                    stepsPerYear_,
+                                    antithetic_,
+                                    samples_, tolerance_,
+                                    maxSamples_,
+                                    seed_,
+                                    polynomOrder_,
+                                    calibrationSamples_,
+                                    ifConst_));
+    }
+
+}
+
+
+#endif
@@ -0,0 +1,395 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file mcbarrierconstengine.hpp
+    \brief Monte Carlo barrier option engine with const parameters
+*/
+
+#ifndef quantlib_montecarlo_barrier_const_engine_hpp
+#define quantlib_montecarlo_barrier_const_engine_hpp
+
+#include <ql/pricingengines/barrier/mcbarrierengine.hpp>
+#include "./blackscholesconstprocess.hpp"
+#include <vector>
+
+namespace QuantLib {
+
+    //! const process that stops evolving once a knock-out barrier is hit
+    /*! Once a grid value is on the wrong side of the barrier the path
+        is frozen there, so the remaining steps of a dead path cost no
+        exponential.
+    */
+    class BlackScholesKnockOutConstProcess : public BlackScholesConstProcess {
+      public:
+        BlackScholesKnockOutConstProcess(
+            const Date& exercisedate,
+            const Handle<Quote>& x0,
+            const Handle<YieldTermStructure>& dividendTS,
+            const Handle<YieldTermStructure>& riskFreeTS,
+            const Handle<BlackVolTermStructure>& blackVolTS,
+            Barrier::Type barrierType,
+            Real barrier)
+        : BlackScholesConstProcess(exercisedate, x0, dividendTS,
+                                   riskFreeTS, blackVolTS),
+          down_(barrierType == Barrier::DownOut), barrier_(barrier) {
+            QL_REQUIRE(barrierType == Barrier::DownOut ||
+                       barrierType == Barrier::UpOut,
+                       "knock-out barrier type required");
+        }
+
+        Real evolve(Time t0, Real x0, Time dt, Real dw) const {
+            if (down_ ? x0 <= barrier_ : x0 >= barrier_)
+                return x0;
+            return BlackScholesConstProcess::evolve(t0, x0, dt, dw);
+        }
+      private:
+        bool down_;
+        Real barrier_;
+    };
+
+
+    //! barrier path pricer with analytic Brownian-bridge correction
+    /*! With a constant sigma the probability that the log-spot crosses
+        the barrier between two grid points, given both ends on the
+        live side, is
+        \f[ p_i = \exp\left(-\frac{2\ln(S_{i-1}/B)\ln(S_i/B)}
+                                  {\sigma^2 \Delta t_i}\right). \f]
+        Instead of drawing against it, the pricer carries the survival
+        probability \f$ \prod_i (1-p_i) \f$ along the path, which keeps
+        the bias low on coarse grids without extra random numbers.
+        A path that is on the wrong side at a grid point is settled
+        immediately. The rebate is paid at expiry.
+    */
+    class BarrierConstPathPricer : public PathPricer<Path> {
+      public:
+        BarrierConstPathPricer(Barrier::Type barrierType,
+                               Real barrier,
+                               Real rebate,
+                               Option::Type type,
+                               Real strike,
+                               DiscountFactor discount,
+                               Volatility sigma,
+                               const TimeGrid& grid,
+                               bool correction)
+        : barrierType_(barrierType), barrier_(barrier), rebate_(rebate),
+          omega_(type == Option::Call ? 1.0 : -1.0), strike_(strike),
+          discount_(discount), correction_(correction),
+          crossingFactor_(grid.size() > 0 ? grid.size()-1 : 0) {
+            QL_REQUIRE(barrier > 0.0, "positive barrier required");
+            for (Size i=0; i<crossingFactor_.size(); ++i)
+                crossingFactor_[i] = -2.0/(sigma*sigma*grid.dt(i));
+        }
+
+        Real operator()(const Path& path) const {
+            Size n = path.length();
+            bool down = (barrierType_ == Barrier::DownIn ||
+                         barrierType_ == Barrier::DownOut);
+            bool knockOut = (barrierType_ == Barrier::DownOut ||
+                             barrierType_ == Barrier::UpOut);
+
+            bool hit = false;
+            Real survival = 1.0;
+            Real previous = std::log(path.front()/barrier_);
+            for (Size i=1; i<n; ++i) {
+                if (down ? path[i] <= barrier_ : path[i] >= barrier_) {
+                    hit = true;
+                    break;
+                }
+                if (correction_) {
+                    Real current = std::log(path[i]/barrier_);
+                    survival *= 1.0 - std::exp(crossingFactor_[i-1]
+                                               * previous * current);
+                    previous = current;
+                }
+            }
+
+            Real payoff = std::max(omega_*(path.back()-strike_), 0.0);
+            if (knockOut) {
+                if (hit)
+                    return rebate_ * discount_;
+                return (survival*payoff + (1.0-survival)*rebate_)
+                     * discount_;
+            } else {
+                if (hit)
+                    return payoff * discount_;
+                return ((1.0-survival)*payoff + survival*rebate_)
+                     * discount_;
+            }
+        }
+      private:
+        Barrier::Type barrierType_;
+        Real barrier_, rebate_, omega_, strike_;
+        DiscountFactor discount_;
+        bool correction_;
+        std::vector<Real> crossingFactor_;
+    };
+
+
+    //! Monte Carlo barrier engine with const parameters
+    /*! Same interface as MCBarrierEngine plus the const flag. When
+        ifConst is set, paths are generated by BlackScholesConstProcess
+        (knock-out paths stop evolving once they are dead) and priced by
+        BarrierConstPathPricer, whose crossing correction is exact for
+        the frozen sigma; a few steps per year are usually enough. If
+        isBiased is set the correction is switched off and the barrier
+        is only monitored on the grid.
+    */
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MCBarrierConstEngine : public MCBarrierEngine<RNG,S> {
+      public:
+        typedef
+        typename McSimulation<SingleVariate,RNG,S>::path_generator_type
+            path_generator_type;
+        typedef
+        typename McSimulation<SingleVariate,RNG,S>::path_pricer_type
+            path_pricer_type;
+        typedef typename McSimulation<SingleVariate,RNG,S>::stats_type
+            stats_type;
+        // constructor
+        MCBarrierConstEngine(
+             const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+             Size timeSteps,
+             Size timeStepsPerYear,
+             bool brownianBridge,
+             bool antitheticVariate,
+             Size requiredSamples,
+             Real requiredTolerance,
+             Size maxSamples,
+             bool isBiased,
+             BigNatural seed,
+             bool ifconst) : MCBarrierEngine<RNG,S>(
+                 process,
+                 timeSteps,
+                 timeStepsPerYear,
+                 brownianBridge,
+                 antitheticVariate,
+                 requiredSamples,
+                 requiredTolerance,
+                 maxSamples,
+                 isBiased,
+                 seed),
+                 ifConst(ifconst),
+                 realProcess(process),
+                 brownianBridge_(brownianBridge),
+                 isBiased_(isBiased),
+                 seed_(seed) {};
+     protected:
+            boost::shared_ptr<path_generator_type> pathGenerator() const {
+                if(ifConst){
+                    const BarrierOption::arguments& args = GenericEngine<BarrierOption::arguments,BarrierOption::results>::arguments_;
+                    Date exercisedate = args.exercise->lastDate();
+                    boost::shared_ptr<BlackScholesConstProcess> constProcess_;
+                    if (args.barrierType == Barrier::DownOut ||
+                        args.barrierType == Barrier::UpOut) {
+                        constProcess_ = boost::shared_ptr<BlackScholesConstProcess>(
+                        new BlackScholesKnockOutConstProcess(
+                            exercisedate,
+                            realProcess->stateVariable(),
+                            realProcess->dividendYield(),
+                            realProcess->riskFreeRate(),
+                            realProcess->blackVolatility(),
+                            args.barrierType,
+                            args.barrier
+                        ));
+                    } else {
+                        constProcess_ = boost::shared_ptr<BlackScholesConstProcess>(
+                        new BlackScholesConstProcess(
+                            exercisedate,
+                            realProcess->stateVariable(),
+                            realProcess->dividendYield(),
+                            realProcess->riskFreeRate(),
+                            realProcess->blackVolatility()
+                        ));
+                    }
+
+                    TimeGrid grid = this->timeGrid();
+                    typename RNG::rsg_type generator =
+                        RNG::make_sequence_generator(grid.size()-1,seed_);
+                    return boost::shared_ptr<path_generator_type>(
+                            new path_generator_type(constProcess_, grid,
+                                           generator, brownianBridge_));
+
+                }else{
+                    return MCBarrierEngine<RNG,S>::pathGenerator();
+                }
+            };
+
+            boost::shared_ptr<path_pricer_type> pathPricer() const {
+                if(ifConst){
+                    const BarrierOption::arguments& args = GenericEngine<BarrierOption::arguments,BarrierOption::results>::arguments_;
+                    boost::shared_ptr<PlainVanillaPayoff> payoff =
+                        boost::dynamic_pointer_cast<PlainVanillaPayoff>(args.payoff);
+                    QL_REQUIRE(payoff, "non-plain payoff given");
+
+                    // same frozen sigma as the path generator
+                    Date exercisedate = args.exercise->lastDate();
+                    BlackScholesConstProcess constProcess_(
+                        exercisedate,
+                        realProcess->stateVariable(),
+                        realProcess->dividendYield(),
+                        realProcess->riskFreeRate(),
+                        realProcess->blackVolatility());
+
+                    TimeGrid grid = this->timeGrid();
+                    return boost::shared_ptr<path_pricer_type>(
+                        new BarrierConstPathPricer(
+                            args.barrierType,
+                            args.barrier,
+                            args.rebate,
+                            payoff->optionType(),
+                            payoff->strike(),
+                            realProcess->riskFreeRate()->discount(grid.back()),
+                            constProcess_.diffusion(),
+                            grid,
+                            !isBiased_));
+                }else{
+                    return MCBarrierEngine<RNG,S>::pathPricer();
+                }
+            };
+            bool ifConst;
+            boost::shared_ptr<GeneralizedBlackScholesProcess> realProcess;
+            bool brownianBridge_;
+            bool isBiased_;
+            BigNatural seed_;
+    };
+
+    //! Monte Carlo barrier const engine factory
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MakeMCBarrierConstEngine {
+      public:
+        MakeMCBarrierConstEngine(
+                    const boost::shared_ptr<GeneralizedBlackScholesProcess>&, bool ifconst);
+        // named parameters
+        MakeMCBarrierConstEngine& withSteps(Size steps);
+        MakeMCBarrierConstEngine& withStepsPerYear(Size steps);
+        MakeMCBarrierConstEngine& withBrownianBridge(bool b = true);
+        MakeMCBarrierConstEngine& withSamples(Size samples);
+        MakeMCBarrierConstEngine& withAbsoluteTolerance(Real tolerance);
+        MakeMCBarrierConstEngine& withMaxSamples(Size samples);
+        MakeMCBarrierConstEngine& withBias(bool b = true);
+        MakeMCBarrierConstEngine& withSeed(BigNatural seed);
+        MakeMCBarrierConstEngine& withAntitheticVariate(bool b = true);
+
+        // conversion to pricing engine
+        operator boost::shared_ptr<PricingEngine>() const;
+      private:
+        boost::shared_ptr<GeneralizedBlackScholesProcess> process_;
+        bool antithetic_;
+        Size steps_, stepsPerYear_, samples_, maxSamples_;
+        Real tolerance_;
+        bool brownianBridge_, biased_;
+        BigNatural seed_;
+        bool ifConst_;
+    };
+
+    template <class RNG, class S>
+    inline MakeMCBarrierConstEngine<RNG,S>::MakeMCBarrierConstEngine(
+             const boost::shared_ptr<GeneralizedBlackScholesProcess>& process, bool ifconst)
+    : process_(process), antithetic_(false),
+      steps_(Null<Size>()), stepsPerYear_(Null<Size>()),
+      samples_(Null<Size>()), maxSamples_(Null<Size>()),
+      tolerance_(Null<Real>()), brownianBridge_(false), biased_(false),
+      seed_(0), ifConst_(ifconst) {}
+
+    template <class RNG, class S>
+    inline MakeMCBarrierConstEngine<RNG,S>&
+    MakeMCBarrierConstEngine<RNG,S>::withSteps(Size steps) {
+        steps_ = steps;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCBarrierConstEngine<RNG,S>&
+    MakeMCBarrierConstEngine<RNG,S>::withStepsPerYear(Size steps) {
+        stepsPerYear_ = steps;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCBarrierConstEngine<RNG,S>&
+    MakeMCBarrierConstEngine<RNG,S>::withSamples(Size samples) {
+        QL_REQUIRE(tolerance_ == Null<Real>(),
+                   "tolerance already set");
+        samples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCBarrierConstEngine<RNG,S>&
+    MakeMCBarrierConstEngine<RNG,S>::withAbsoluteTolerance(Real tolerance) {
+        QL_REQUIRE(samples_ == Null<Size>(),
+                   "number of samples already set");
+        QL_REQUIRE(RNG::allowsErrorEstimate,
+                   "chosen random generator policy "
+                   "does not allow an error estimate");
+        tolerance_ = tolerance;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCBarrierConstEngine<RNG,S>&
+    MakeMCBarrierConstEngine<RNG,S>::withMaxSamples(Size samples) {
+        maxSamples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCBarrierConstEngine<RNG,S>&
+    MakeMCBarrierConstEngine<RNG,S>::withBias(bool biased) {
+        biased_ = biased;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCBarrierConstEngine<RNG,S>&
+    MakeMCBarrierConstEngine<RNG,S>::withSeed(BigNatural seed) {
+        seed_ = seed;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCBarrierConstEngine<RNG,S>&
+    MakeMCBarrierConstEngine<RNG,S>::withBrownianBridge(bool brownianBridge) {
+        brownianBridge_ = brownianBridge;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCBarrierConstEngine<RNG,S>&
+    MakeMCBarrierConstEngine<RNG,S>::withAntitheticVariate(bool b) {
+        antithetic_ = b;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline
+    MakeMCBarrierConstEngine<RNG,S>::operator boost::shared_ptr<PricingEngine>()
+                                                                      const {
+        QL_REQUIRE(steps_ != Null<Size>() || stepsPerYear_ != Null<Size>(),
+                   "number of steps not given");
+        QL_REQUIRE(steps_ == Null<Size>() || stepsPerYear_ == Null<Size>(),
+                   "number of steps overspecified");
+        return boost::shared_ptr<PricingEngine>(new
+            MCBarrierConstEngine<RNG,S>(process_,
+                                    steps_,
+                                    stepsPerYear_,
+                                    brownianBridge_,
+                                    antithetic_,
+                                    samples_, tolerance_,
+                                    maxSamples_,
+                                    biased_,
+                                    seed_,
+                                    ifConst_));
+    }
+
+}
+
+
+#endif
@@ -0,0 +1,247 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file mcconstscenarioengine.hpp
+    \brief scenario-grid repricing on common random numbers
+*/
+
+#ifndef quantlib_montecarlo_const_scenario_engine_hpp
+#define quantlib_montecarlo_const_scenario_engine_hpp
+
+#include <ql/processes/blackscholesprocess.hpp>
+#include <ql/instruments/payoffs.hpp>
+#include <ql/methods/montecarlo/brownianbridge.hpp>
+#include <ql/math/randomnumbers/rngtraits.hpp>
+#include <ql/timegrid.hpp>
+#include "./blackscholesconstprocess.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace QuantLib {
+
+    //! frozen market of one scenario
+    struct ConstScenario {
+        Real spot;
+        Rate riskFreeForward;
+        Rate dividendForward;
+        Volatility volatility;
+
+        //! frozen values of a real process, as the const engines take them
+        static ConstScenario frozen(
+            const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+            const Date& exercisedate) {
+            BlackScholesConstProcess p(exercisedate,
+                                       process->stateVariable(),
+                                       process->dividendYield(),
+                                       process->riskFreeRate(),
+                                       process->blackVolatility());
+            ConstScenario s = { p.x0(), p.riskFreeForward(),
+                                p.dividendForward(), p.diffusion(0.0, p.x0()) };
+            return s;
+        }
+
+        //! relative spot shock, absolute vol and rate shocks
+        ConstScenario shocked(Real spotShift,
+                              Volatility volShift,
+                              Rate rateShift) const {
+            ConstScenario s = { spot*(1.0+spotShift),
+                                riskFreeForward+rateShift,
+                                dividendForward,
+                                volatility+volShift };
+            return s;
+        }
+    };
+
+    //! value of one scenario and its P&L against the base scenario
+    struct ScenarioResult {
+        Real value, errorEstimate;
+        Real pnl, pnlErrorEstimate;
+    };
+
+
+    //! Monte Carlo repricing of one option over a grid of scenarios
+    /*! The normals are drawn once per path and turned into the
+        Brownian path on the time grid; every scenario then reads its
+        own frozen (S0, r, q, sigma) from flat arrays and prices on the
+        same Brownian path in an inner loop over scenarios, so the
+        random numbers, the Brownian bridge and the loop overhead are
+        paid once for the whole grid. The first scenario is the base;
+        the P&L of scenario i is accumulated pathwise against it, so
+        its error reflects common random numbers.
+
+        Payoffs are plain vanilla European on the terminal value, or
+        arithmetic average price on given fixing times as in
+        MCDiscreteArithmeticAPConstEngine.
+    */
+    template <class RNG = PseudoRandom>
+    class MCConstScenarioEngine {
+      public:
+        typedef typename RNG::rsg_type rsg_type;
+
+        MCConstScenarioEngine(Size requiredSamples,
+                              BigNatural seed,
+                              bool antitheticVariate = false,
+                              bool brownianBridge = false)
+        : requiredSamples_(requiredSamples), seed_(seed),
+          antitheticVariate_(antitheticVariate),
+          brownianBridge_(brownianBridge) {
+            QL_REQUIRE(requiredSamples_ > 1, "too few samples");
+        }
+
+        std::vector<ScenarioResult> europeanValues(
+                const boost::shared_ptr<StrikedTypePayoff>& payoff,
+                Time maturity,
+                const std::vector<ConstScenario>& scenarios,
+                Size timeSteps = 1) const {
+            TimeGrid grid(maturity, timeSteps);
+            return simulate(payoff, grid, false, 0.0, 0, scenarios);
+        }
+
+        std::vector<ScenarioResult> arithmeticAsianValues(
+                const boost::shared_ptr<StrikedTypePayoff>& payoff,
+                const std::vector<Time>& fixingTimes,
+                const std::vector<ConstScenario>& scenarios,
+                Real runningSum = 0.0,
+                Size pastFixings = 0) const {
+            TimeGrid grid(fixingTimes.begin(), fixingTimes.end());
+            return simulate(payoff, grid, true, runningSum, pastFixings,
+                            scenarios);
+        }
+
+      private:
+        std::vector<ScenarioResult> simulate(
+                const boost::shared_ptr<StrikedTypePayoff>& payoff,
+                const TimeGrid& grid,
+                bool average,
+                Real runningSum,
+                Size pastFixings,
+                const std::vector<ConstScenario>& scenarios) const {
+            QL_REQUIRE(payoff, "no payoff given");
+            QL_REQUIRE(!scenarios.empty(), "no scenarios given");
+            const Size m = scenarios.size();
+            const Size n = grid.size()-1;
+            QL_REQUIRE(n > 0, "empty time grid");
+
+            // scenario arrays
+            std::vector<Real> logSpot(m), drift(m), sigma(m), discount(m);
+            for (Size s=0; s<m; ++s) {
+                const ConstScenario& c = scenarios[s];
+                QL_REQUIRE(c.spot > 0.0,
+                           "scenario " << s << ": non-positive spot ("
+                           << c.spot << ")");
+                QL_REQUIRE(c.volatility >= 0.0,
+                           "scenario " << s << ": negative volatility ("
+                           << c.volatility << ")");
+                logSpot[s] = std::log(c.spot);
+                drift[s] = c.riskFreeForward - c.dividendForward
+                         - 0.5*c.volatility*c.volatility;
+                sigma[s] = c.volatility;
+                discount[s] = std::exp(-c.riskFreeForward*grid.back());
+            }
+
+            // fixings: grid nodes 1..n, plus the spot if t=0 is one
+            bool includeSpot = average &&
+                               grid.mandatoryTimes()[0] == 0.0;
+            Size fixings = pastFixings + n + (includeSpot ? 1 : 0);
+            const Real sign = (payoff->optionType() == Option::Call ?
+                               1.0 : -1.0);
+            const Real strike = payoff->strike();
+
+            rsg_type generator = RNG::make_sequence_generator(n, seed_);
+            boost::shared_ptr<BrownianBridge> bridge;
+            if (brownianBridge_)
+                bridge = boost::shared_ptr<BrownianBridge>(
+                                                  new BrownianBridge(grid));
+            std::vector<Real> sqrtDt(n);
+            for (Size k=0; k<n; ++k)
+                sqrtDt[k] = std::sqrt(grid.dt(k));
+
+            std::vector<Real> dw(n), w(n);
+            std::vector<Real> level(m), price(m), acc(m);
+            std::vector<Real> sum(m, 0.0), sumSq(m, 0.0);
+            std::vector<Real> pnlSum(m, 0.0), pnlSumSq(m, 0.0);
+
+            for (Size j=0; j<requiredSamples_; ++j) {
+                const typename rsg_type::sample_type& sequence =
+                    generator.nextSequence();
+                if (bridge) {
+                    bridge->transform(sequence.value.begin(),
+                                      sequence.value.end(), dw.begin());
+                } else {
+                    for (Size k=0; k<n; ++k)
+                        dw[k] = sequence.value[k]*sqrtDt[k];
+                }
+                Real x = 0.0;
+                for (Size k=0; k<n; ++k)
+                    w[k] = (x += dw[k]);
+
+                std::fill(price.begin(), price.end(), 0.0);
+                Size branches = antitheticVariate_ ? 2 : 1;
+                for (Size b=0; b<branches; ++b) {
+                    Real eps = (b == 0 ? 1.0 : -1.0);
+                    if (average) {
+                        for (Size s=0; s<m; ++s)
+                            acc[s] = runningSum
+                                   + (includeSpot ? scenarios[s].spot : 0.0);
+                        for (Size k=0; k<n; ++k) {
+                            const Real t = grid[k+1], wk = eps*w[k];
+                            for (Size s=0; s<m; ++s)
+                                acc[s] += std::exp(logSpot[s] + drift[s]*t
+                                                   + sigma[s]*wk);
+                        }
+                        for (Size s=0; s<m; ++s)
+                            level[s] = acc[s]/fixings;
+                    } else {
+                        const Real T = grid.back(), wT = eps*w[n-1];
+                        for (Size s=0; s<m; ++s)
+                            level[s] = std::exp(logSpot[s] + drift[s]*T
+                                                + sigma[s]*wT);
+                    }
+                    for (Size s=0; s<m; ++s)
+                        price[s] += discount[s]
+                                  * std::max(sign*(level[s]-strike), 0.0);
+                }
+
+                const Real scale = 1.0/branches;
+                const Real base = price[0]*scale;
+                for (Size s=0; s<m; ++s) {
+                    Real p = price[s]*scale, d = p - base;
+                    sum[s] += p;
+                    sumSq[s] += p*p;
+                    pnlSum[s] += d;
+                    pnlSumSq[s] += d*d;
+                }
+            }
+
+            const Real N = Real(requiredSamples_);
+            std::vector<ScenarioResult> results(m);
+            for (Size s=0; s<m; ++s) {
+                Real mean = sum[s]/N;
+                Real pnlMean = pnlSum[s]/N;
+                results[s].value = mean;
+                results[s].errorEstimate =
+                    std::sqrt(std::max(sumSq[s]/N - mean*mean, 0.0)/(N-1.0));
+                results[s].pnl = pnlMean;
+                results[s].pnlErrorEstimate =
+                    std::sqrt(std::max(pnlSumSq[s]/N - pnlMean*pnlMean,
+                                       0.0)/(N-1.0));
+            }
+            return results;
+        }
+
+        Size requiredSamples_;
+        BigNatural seed_;
+        bool antitheticVariate_, brownianBridge_;
+    };
+
+}
+
+
+#endif
@@ -0,0 +1,227 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file mceuropeanbasketconstengine.hpp
+    \brief Monte Carlo basket/spread option engine with const parameters
+*/
+
+#ifndef quantlib_montecarlo_european_basket_const_engine_hpp
+#define quantlib_montecarlo_european_basket_const_engine_hpp
+
+#include <ql/pricingengines/basket/mceuropeanbasketengine.hpp>
+#include <ql/processes/stochasticprocessarray.hpp>
+#include "./blackscholesconstmultiprocess.hpp"
+
+namespace QuantLib {
+
+    //! Monte Carlo basket engine on the const multi-asset process
+    /*! Takes the same StochasticProcessArray as MCEuropeanBasketEngine.
+        When ifConst is set, the components are frozen at the exercise
+        date into a BlackScholesConstMultiProcess, so that paths are
+        generated without calling the term structures of each component
+        on every step. Any BasketPayoff (including SpreadBasketPayoff)
+        is priced by the usual EuropeanMultiPathPricer.
+    */
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MCEuropeanBasketConstEngine : public MCEuropeanBasketEngine<RNG,S> {
+      public:
+        typedef
+        typename McSimulation<MultiVariate,RNG,S>::path_generator_type
+            path_generator_type;
+        typedef typename McSimulation<MultiVariate,RNG,S>::path_pricer_type
+            path_pricer_type;
+        typedef typename McSimulation<MultiVariate,RNG,S>::stats_type
+            stats_type;
+        // constructor
+        MCEuropeanBasketConstEngine(
+             const boost::shared_ptr<StochasticProcessArray>& processes,
+             Size timeSteps,
+             Size timeStepsPerYear,
+             bool brownianBridge,
+             bool antitheticVariate,
+             Size requiredSamples,
+             Real requiredTolerance,
+             Size maxSamples,
+             BigNatural seed,
+             bool ifconst) : MCEuropeanBasketEngine<RNG,S>(
+                 processes,
+                 timeSteps,
+                 timeStepsPerYear,
+                 brownianBridge,
+                 antitheticVariate,
+                 requiredSamples,
+                 requiredTolerance,
+                 maxSamples,
+                 seed),
+                 ifConst(ifconst),
+                 realProcesses(processes),
+                 brownianBridge_(brownianBridge),
+                 seed_(seed) {};
+     protected:
+            boost::shared_ptr<path_generator_type> pathGenerator() const {
+                if(ifConst){
+                    Date exercisedate = GenericEngine<BasketOption::arguments,BasketOption::results>::arguments_.exercise->lastDate();
+                    Size numAssets = realProcesses->size();
+                    std::vector<boost::shared_ptr<GeneralizedBlackScholesProcess> >
+                        processes(numAssets);
+                    for (Size i=0; i<numAssets; ++i) {
+                        processes[i] =
+                            boost::dynamic_pointer_cast<GeneralizedBlackScholesProcess>(
+                                                   realProcesses->process(i));
+                        QL_REQUIRE(processes[i],
+                                   "Black-Scholes process required");
+                    }
+                    boost::shared_ptr<BlackScholesConstMultiProcess> constProcess_(
+                    new BlackScholesConstMultiProcess(
+                        exercisedate,
+                        processes,
+                        realProcesses->correlation()
+                    ));
+
+                    TimeGrid grid = this->timeGrid();
+                    typename RNG::rsg_type generator =
+                        RNG::make_sequence_generator(numAssets*(grid.size()-1),seed_);
+                    return boost::shared_ptr<path_generator_type>(
+                            new path_generator_type(constProcess_, grid,
+                                           generator, brownianBridge_));
+
+                }else{
+                    return MCEuropeanBasketEngine<RNG,S>::pathGenerator();
+                }
+            };
+            bool ifConst;
+            boost::shared_ptr<StochasticProcessArray> realProcesses;
+            bool brownianBridge_;
+            BigNatural seed_;
+    };
+
+    //! Monte Carlo basket const engine factory
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MakeMCEuropeanBasketConstEngine {
+      public:
+        MakeMCEuropeanBasketConstEngine(
+                    const boost::shared_ptr<StochasticProcessArray>&, bool ifconst);
+        // named parameters
+        MakeMCEuropeanBasketConstEngine& withSteps(Size steps);
+        MakeMCEuropeanBasketConstEngine& withStepsPerYear(Size steps);
+        MakeMCEuropeanBasketConstEngine& withBrownianBridge(bool b = true);
+        MakeMCEuropeanBasketConstEngine& withSamples(Size samples);
+        MakeMCEuropeanBasketConstEngine& withAbsoluteTolerance(Real tolerance);
+        MakeMCEuropeanBasketConstEngine& withMaxSamples(Size samples);
+        MakeMCEuropeanBasketConstEngine& withSeed(BigNatural seed);
+        MakeMCEuropeanBasketConstEngine& withAntitheticVariate(bool b = true);
+
+        // conversion to pricing engine
+        operator boost::shared_ptr<PricingEngine>() const;
+      private:
+        boost::shared_ptr<StochasticProcessArray> process_;
+        bool antithetic_;
+        Size steps_, stepsPerYear_, samples_, maxSamples_;
+        Real tolerance_;
+        bool brownianBridge_;
+        BigNatural seed_;
+        bool ifConst_;
+    };
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanBasketConstEngine<RNG,S>::MakeMCEuropeanBasketConstEngine(
+             const boost::shared_ptr<StochasticProcessArray>& process, bool ifconst)
+    : process_(process), antithetic_(false),
+      steps_(Null<Size>()), stepsPerYear_(Null<Size>()),
+      samples_(Null<Size>()), maxSamples_(Null<Size>()),
+      tolerance_(Null<Real>()), brownianBridge_(false), seed_(0), ifConst_(ifconst) {}
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanBasketConstEngine<RNG,S>&
+    MakeMCEuropeanBasketConstEngine<RNG,S>::withSteps(Size steps) {
+        steps_ = steps;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanBasketConstEngine<RNG,S>&
+    MakeMCEuropeanBasketConstEngine<RNG,S>::withStepsPerYear(Size steps) {
+        stepsPerYear_ = steps;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanBasketConstEngine<RNG,S>&
+    MakeMCEuropeanBasketConstEngine<RNG,S>::withSamples(Size samples) {
+        QL_REQUIRE(tolerance_ == Null<Real>(),
+                   "tolerance already set");
+        samples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanBasketConstEngine<RNG,S>&
+    MakeMCEuropeanBasketConstEngine<RNG,S>::withAbsoluteTolerance(Real tolerance) {
+        QL_REQUIRE(samples_ == Null<Size>(),
+                   "number of samples already set");
+        QL_REQUIRE(RNG::allowsErrorEstimate,
+                   "chosen random generator policy "
+                   "does not allow an error estimate");
+        tolerance_ = tolerance;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanBasketConstEngine<RNG,S>&
+    MakeMCEuropeanBasketConstEngine<RNG,S>::withMaxSamples(Size samples) {
+        maxSamples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanBasketConstEngine<RNG,S>&
+    MakeMCEuropeanBasketConstEngine<RNG,S>::withSeed(BigNatural seed) {
+        seed_ = seed;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanBasketConstEngine<RNG,S>&
+    MakeMCEuropeanBasketConstEngine<RNG,S>::withBrownianBridge(bool brownianBridge) {
+        brownianBridge_ = brownianBridge;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanBasketConstEngine<RNG,S>&
+    MakeMCEuropeanBasketConstEngine<RNG,S>::withAntitheticVariate(bool b) {
+        antithetic_ = b;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline
+    MakeMCEuropeanBasketConstEngine<RNG,S>::operator boost::shared_ptr<PricingEngine>()
+                                                                      const {
+        QL_REQUIRE(steps_ != Null<Size>() || stepsPerYear_ != Null<Size>(),
+                   "number of steps not given");
+        QL_REQUIRE(steps_ == Null<Size>() || stepsPerYear_ == Null<Size>(),
+                   "number of steps overspecified");
+        return boost::shared_ptr<PricingEngine>(new
+            MCEuropeanBasketConstEngine<RNG,S>(process_,
+                                    steps_,
+                                    stepsPerYear_,
+                                    brownianBridge_,
+                                    antithetic_,
+                                    samples_, tolerance_,
+                                    maxSamples_,
+                                    seed_,
+                                    ifConst_));
+    }
+
+}
+
+
+#endif
@@ -16,12 +16,58 @@
 #define quantlib_montecarlo_european_const_engine_hpp
 
 #include <ql/pricingengines/vanilla/mceuropeanengine.hpp>
+#include <ql/math/distributions/normaldistribution.hpp>
 #include "./blackscholesconstprocess.hpp"
+#include "./localvolgridprocess.hpp"
+#include "./constresultcache.hpp"
+#include "./constsimulationcontext.hpp"
 #include <iostream>
+#include <typeinfo>
 using namespace std;
 
 namespace QuantLib {
 
+    //! European path pricer under a constant drift shift
+    /*! On frozen parameters the terminal value only depends on the
+        terminal Brownian value \f$ W_T \f$. The pricer moves it to
+        \f$ W_T + \theta T \f$, i.e. multiplies \f$ S_T \f$ by
+        \f$ e^{\sigma\theta T} \f$, and weights the payoff by the
+        likelihood ratio \f$ \exp(-\theta W_T - \theta^2 T/2) \f$.
+        The likelihood ratio is only computed for paths that pay.
+    */
+    class ImportanceSamplingEuropeanPathPricer : public PathPricer<Path> {
+      public:
+        ImportanceSamplingEuropeanPathPricer(Option::Type type,
+                                             Real strike,
+                                             DiscountFactor discount,
+                                             Real drift,
+                                             Volatility sigma,
+                                             Time maturity,
+                                             Real theta)
+        : payoff_(type, strike), discount_(discount),
+          growth_(std::exp(sigma*theta*maturity)),
+          slope_(-theta/sigma),
+          level_(theta*drift*maturity/sigma - 0.5*theta*theta*maturity) {
+            QL_REQUIRE(strike>=0.0,
+                       "strike less than zero not allowed");
+            QL_REQUIRE(sigma>0.0,
+                       "positive volatility required");
+        }
+
+        Real operator()(const Path& path) const {
+            QL_REQUIRE(path.length() > 0, "the path cannot be empty");
+            Real value = payoff_(path.back() * growth_);
+            if (value == 0.0)
+                return 0.0;
+            Real logReturn = std::log(path.back()/path.front());
+            return value * std::exp(level_ + slope_*logReturn) * discount_;
+        }
+      private:
+        PlainVanillaPayoff payoff_;
+        DiscountFactor discount_;
+        Real growth_, slope_, level_;
+    };
+
     template <class RNG = PseudoRandom, class S = Statistics>
     class MCEuropeanConstEngine : public MCEuropeanEngine<RNG,S> {
       public:
@@ -44,7 +90,13 @@ namespace QuantLib {
              Real requiredTolerance,
              Size maxSamples,
              BigNatural seed,
-             bool ifconst) : MCEuropeanEngine<RNG,S>(
+             bool ifconst,
+             bool importanceSampling = false,
+             bool localVolGrid = false,
+             const boost::shared_ptr<ConstResultCache>& cache =
+                           boost::shared_ptr<ConstResultCache>(),
+             Size strata = 1,
+             bool momentMatching = false) : MCEuropeanEngine<RNG,S>(
                  process,
                  timeSteps,
                  timeStepsPerYear,
@@ -57,33 +109,352 @@ namespace QuantLib {
                  realProcess(process),
                  seed_(seed),
                  brownianBridge_(brownianBridge),
-                 ifConst(ifconst){};   
+                 ifConst(ifconst),
+                 importanceSampling_(importanceSampling),
+                 localVolGrid_(localVolGrid),
+                 cache_(cache),
+                 strata_(strata),
+                 momentMatching_(momentMatching),
+                 lastRunToppedUp_(false),
+                 context_(seed, brownianBridge){
+                     QL_REQUIRE(ifconst || !importanceSampling,
+                                "importance sampling requires "
+                                "constant parameters");
+                     QL_REQUIRE(!(localVolGrid && importanceSampling),
+                                "importance sampling requires "
+                                "a constant volatility");
+                     QL_REQUIRE(strata >= 1, "at least one stratum required");
+                     QL_REQUIRE(!stratified() ||
+                                (ifconst && !localVolGrid &&
+                                 !importanceSampling),
+                                "stratification and moment matching "
+                                "require constant parameters");
+                 };
+
+            /* Results are only cached when they are a function of the
+               key: frozen parameters, no local-vol grid (which depends
+               on the whole surface) and a fixed seed. Stratified runs
+               are not cached, since a hit would only restore the value
+               and error and lose the "samples" result.
+
+               On frozen parameters the Monte Carlo model is also kept
+               after a run. If the next run has the same inputs and asks
+               for at least as many samples, or for a tolerance, the
+               model continues the same random stream and only the
+               extra paths are simulated; the result is the one a
+               single run with the final number of samples gives. */
+            void calculate() const {
+                lastRunToppedUp_ = false;
+                bool frozen = ifConst && !localVolGrid_;
+                bool cacheable = cache_ && frozen && !stratified() &&
+                                 (seed_ != 0 || !RNG::allowsErrorEstimate);
+                if (!frozen) {
+                    lastInputKey_.reset();
+                    MCEuropeanEngine<RNG,S>::calculate();
+                    return;
+                }
+                ConstResultCache::Key inputs = inputKey();
+                ConstResultCache::Key key = cacheKey(inputs);
+                if (cacheable && cache_->find(key, this->results_.value,
+                                              this->results_.errorEstimate)) {
+                    lastRunToppedUp_ = true;
+                    return;
+                }
+
+                if (stratified()) {
+                    lastInputKey_.reset();
+                    stratifiedCalculate();
+                } else if (canTopUp(inputs)) {
+                    lastRunToppedUp_ = true;
+                    if (this->requiredTolerance_ != Null<Real>())
+                        this->value(this->requiredTolerance_,
+                                    this->maxSamples_ == Null<Size>() ?
+                                    QL_MAX_INTEGER : this->maxSamples_);
+                    else
+                        this->valueWithSamples(this->requiredSamples_);
+                    this->results_.value =
+                        this->mcModel_->sampleAccumulator().mean();
+                    if (RNG::allowsErrorEstimate)
+                        this->results_.errorEstimate =
+                            this->mcModel_->sampleAccumulator().errorEstimate();
+                } else {
+                    lastInputKey_.reset();
+                    MCEuropeanEngine<RNG,S>::calculate();
+                    lastInputKey_ = boost::shared_ptr<ConstResultCache::Key>(
+                                           new ConstResultCache::Key(inputs));
+                }
+
+                if (cacheable)
+                    cache_->insert(key, this->results_.value,
+                                   this->results_.errorEstimate);
+            }
+
+            //! whether the last run only added paths to, or reused, earlier ones
+            bool lastRunToppedUp() const { return lastRunToppedUp_; }
+
+            //! starts the paths at the n-th sequence of the seed's stream
+            void setFirstSample(Size n) {
+                QL_REQUIRE(ifConst && !localVolGrid_ && !stratified(),
+                           "sample offset requires constant parameters");
+                // if the last run stopped at the n-th sequence, the context
+                // goes on from there instead of skipping from the seed
+                Size drawn = this->mcModel_ ?
+                    this->mcModel_->sampleAccumulator().samples() : 0;
+                context_.setFirstSample(n, drawn);
+                this->update();
+            }
+
+            //! asks for more samples; the next run tops up if it can
+            void setRequiredSamples(Size samples) {
+                this->requiredTolerance_ = Null<Real>();
+                this->requiredSamples_ = samples;
+                this->update();
+            }
+
+            //! asks for a tolerance; the next run tops up if it can
+            void setRequiredTolerance(Real tolerance) {
+                QL_REQUIRE(RNG::allowsErrorEstimate,
+                           "chosen random generator policy "
+                           "does not allow an error estimate");
+                this->requiredSamples_ = Null<Size>();
+                this->requiredTolerance_ = tolerance;
+                this->update();
+            }
      protected:
-            boost::shared_ptr<path_generator_type> pathGenerator() const {
-                if(ifConst){
-                    Date exercisedate = GenericEngine<OneAssetOption::arguments,OneAssetOption::results>::arguments_.exercise->lastDate(); 
-                    boost::shared_ptr<BlackScholesConstProcess> constProcess_(
+            bool canTopUp(const ConstResultCache::Key& inputs) const {
+                if (!this->mcModel_ || !lastInputKey_ ||
+                    !(*lastInputKey_ == inputs))
+                    return false;
+                return this->requiredTolerance_ != Null<Real>() ||
+                       this->requiredSamples_ >=
+                       this->mcModel_->sampleAccumulator().samples();
+            }
+
+            // everything the price depends on but the sample settings
+            ConstResultCache::Key inputKey() const {
+                boost::shared_ptr<StrikedTypePayoff> payoff =
+                    boost::dynamic_pointer_cast<StrikedTypePayoff>(
+                        GenericEngine<OneAssetOption::arguments,OneAssetOption::results>::arguments_.payoff);
+                QL_REQUIRE(payoff, "non-striked payoff given");
+                boost::shared_ptr<BlackScholesConstProcess> constProcess_ =
+                    constProcess();
+                TimeGrid grid = this->timeGrid();
+
+                ConstResultCache::Key key(std::string("MCEuropeanConstEngine/")
+                                          + typeid(RNG).name() + "/"
+                                          + payoff->name());
+                key << constProcess_->x0()
+                    << constProcess_->riskFreeForward()
+                    << constProcess_->dividendForward()
+                    << constProcess_->diffusion()
+                    << grid.back() << Real(grid.size())
+                    << Real(payoff->optionType()) << payoff->strike()
+                    << Real(seed_)
+                    << Real(this->antitheticVariate_)
+                    << Real(brownianBridge_)
+                    << Real(importanceSampling_)
+                    << Real(strata_) << Real(momentMatching_)
+                    << Real(context_.firstSample());
+                return key;
+            }
+
+            ConstResultCache::Key cacheKey(
+                                 const ConstResultCache::Key& inputs) const {
+                ConstResultCache::Key key = inputs;
+                key << Real(this->requiredSamples_)
+                    << this->requiredTolerance_
+                    << Real(this->maxSamples_);
+                return key;
+            }
+
+            bool stratified() const {
+                return strata_ > 1 || momentMatching_;
+            }
+
+            /* On frozen parameters S_T = S_0 exp(drift T + sigma W_T)
+               exactly, so the terminal normal is drawn directly.
+
+               A batch holds one normal in each of the strata
+               equal-probability strata, Z = N^{-1}((j+U_j)/strata),
+               which in one dimension is also a Latin hypercube sample.
+               With moment matching the normals of a batch are shifted
+               and scaled to sample mean 0 and variance 1, so that the
+               log-return has the frozen mean and variance exactly;
+               without strata a batch is then 256 plain draws. Batches
+               are independent, so the error estimate is the standard
+               error of the batch means, which is correct across strata
+               and with matched moments. The number of batches follows
+               the samples or the tolerance as in McSimulation; a
+               tolerance is only tested once there are at least 30
+               batches, below which their standard error is too rough
+               to stop on. The "samples" result counts the payoffs
+               evaluated, antithetic ones included. */
+            void stratifiedCalculate() const {
+                boost::shared_ptr<PlainVanillaPayoff> payoff =
+                    boost::dynamic_pointer_cast<PlainVanillaPayoff>(
+                        GenericEngine<OneAssetOption::arguments,OneAssetOption::results>::arguments_.payoff);
+                QL_REQUIRE(payoff, "non-plain payoff given");
+
+                boost::shared_ptr<BlackScholesConstProcess> constProcess_ =
+                    constProcess();
+                Time maturity = this->timeGrid().back();
+                Real logSpot = std::log(constProcess_->x0());
+                Real mean = constProcess_->drift()*maturity;
+                Real stdDev = constProcess_->diffusion()*std::sqrt(maturity);
+                DiscountFactor discount =
+                    realProcess->riskFreeRate()->discount(maturity);
+
+                Size batchSize = strata_ > 1 ? strata_ : 256;
+                typename RNG::ursg_type uniforms(batchSize, seed_);
+                InverseCumulativeNormal inverse;
+                std::vector<Real> z(batchSize);
+                Real sum = 0.0, sumSq = 0.0;
+                Size batches = 0;
+
+                const Size minimumBatches = 30;
+                bool tolerance = this->requiredTolerance_ != Null<Real>();
+                Size target = tolerance ? 1023 : this->requiredSamples_;
+                QL_REQUIRE(target != Null<Size>(),
+                           "neither tolerance nor number of samples set");
+                Size next = std::max<Size>(tolerance ? minimumBatches : 2,
+                                           (target+batchSize-1)/batchSize);
+                Size maxBatches = this->maxSamples_ == Null<Size>() ?
+                                  QL_MAX_INTEGER :
+                                  std::max<Size>(2, this->maxSamples_/batchSize);
+                Real error = QL_MAX_REAL;
+                for (;;) {
+                    for (Size b=0; b<next; ++b) {
+                        const std::vector<Real>& u =
+                            uniforms.nextSequence().value;
+                        for (Size j=0; j<batchSize; ++j)
+                            z[j] = inverse(strata_ > 1 ?
+                                           (j + u[j])/batchSize : u[j]);
+                        if (momentMatching_) {
+                            Real m = 0.0, v = 0.0;
+                            for (Size j=0; j<batchSize; ++j)
+                                m += z[j];
+                            m /= batchSize;
+                            for (Size j=0; j<batchSize; ++j)
+                                v += (z[j]-m)*(z[j]-m);
+                            Real scale = 1.0/std::sqrt(v/batchSize);
+                            for (Size j=0; j<batchSize; ++j)
+                                z[j] = (z[j]-m)*scale;
+                        }
+                        Real value = 0.0;
+                        for (Size j=0; j<batchSize; ++j) {
+                            value += (*payoff)(std::exp(logSpot + mean
+                                                        + stdDev*z[j]));
+                            if (this->antitheticVariate_)
+                                value += (*payoff)(std::exp(logSpot + mean
+                                                            - stdDev*z[j]));
+                        }
+                        value *= discount /
+                            (batchSize * (this->antitheticVariate_ ? 2 : 1));
+                        sum += value;
+                        sumSq += value*value;
+                    }
+                    batches += next;
+                    Real average = sum/batches;
+                    error = std::sqrt(std::max(sumSq/batches - average*average,
+                                               0.0)/(batches-1));
+                    if (!tolerance || error <= this->requiredTolerance_)
+                        break;
+                    Real order = error*error/this->requiredTolerance_
+                                              /this->requiredTolerance_;
+                    next = Size(std::max<Real>(batches*order*0.8 - batches,
+                                               2.0));
+                    next = batches < maxBatches ?
+                           std::min(next, maxBatches - batches) : 0;
+                    QL_REQUIRE(next > 0,
+                               "max number of samples (" << this->maxSamples_
+                               << ") reached, while error (" << error
+                               << ") is still above tolerance ("
+                               << this->requiredTolerance_ << ")");
+                }
+
+                this->results_.value = sum/batches;
+                if (RNG::allowsErrorEstimate)
+                    this->results_.errorEstimate = error;
+                this->results_.additionalResults["samples"] =
+                    Real(batches*batchSize*(this->antitheticVariate_ ? 2 : 1));
+            }
+
+            boost::shared_ptr<BlackScholesConstProcess> constProcess() const {
+                Date exercisedate = GenericEngine<OneAssetOption::arguments,OneAssetOption::results>::arguments_.exercise->lastDate();
+                return boost::shared_ptr<BlackScholesConstProcess>(
                     new BlackScholesConstProcess(
                         exercisedate,
                         realProcess->stateVariable(),
                         realProcess->dividendYield(),
                         realProcess->riskFreeRate(),
-                        realProcess->blackVolatility()                                              
+                        realProcess->blackVolatility()
                     ));
-                    
-                    Size dimensions = constProcess_->factors();
+            }
+
+            boost::shared_ptr<path_generator_type> pathGenerator() const {
+                if(localVolGrid_){
+                    Date exercisedate = GenericEngine<OneAssetOption::arguments,OneAssetOption::results>::arguments_.exercise->lastDate();
                     TimeGrid grid = this->timeGrid();
+                    boost::shared_ptr<LocalVolGridProcess> gridProcess_(
+                        new LocalVolGridProcess(exercisedate, realProcess,
+                                                grid));
                     typename RNG::rsg_type generator =
-                        RNG::make_sequence_generator(dimensions*(grid.size()-1),seed_);
+                        RNG::make_sequence_generator(grid.size()-1,seed_);
                     return boost::shared_ptr<path_generator_type>(
-                            new path_generator_type(constProcess_, grid,
+                            new path_generator_type(gridProcess_, grid,
                                            generator, brownianBridge_));
-                    
+                }else if(ifConst){
+                    // grid, generator and bridge are kept between runs
+                    Date exercisedate = GenericEngine<OneAssetOption::arguments,OneAssetOption::results>::arguments_.exercise->lastDate();
+                    return context_.pathGenerator(realProcess, exercisedate,
+                                                  this->timeGrid());
                 }else{
                     return MCEuropeanEngine<RNG,S>::pathGenerator();
                 }
             };
+
+            /* The shift moves the median of the terminal value onto the
+               strike, theta = (ln(K/S0) - drift*T)/(sigma*T); it is only
+               applied when the option is out of the money in that sense,
+               so that in-the-money options keep the plain pricer. */
+            boost::shared_ptr<path_pricer_type> pathPricer() const {
+                if(importanceSampling_){
+                    boost::shared_ptr<PlainVanillaPayoff> payoff =
+                        boost::dynamic_pointer_cast<PlainVanillaPayoff>(
+                            GenericEngine<OneAssetOption::arguments,OneAssetOption::results>::arguments_.payoff);
+                    QL_REQUIRE(payoff, "non-plain payoff given");
+
+                    boost::shared_ptr<BlackScholesConstProcess> constProcess_ =
+                        constProcess();
+                    Time maturity = this->timeGrid().back();
+                    Real drift = constProcess_->drift();
+                    Volatility sigma = constProcess_->diffusion();
+                    Real theta = (std::log(payoff->strike()/constProcess_->x0())
+                                  - drift*maturity) / (sigma*maturity);
+                    bool outOfTheMoney = (payoff->optionType() == Option::Call ?
+                                          theta > 0.0 : theta < 0.0);
+                    if (outOfTheMoney)
+                        return boost::shared_ptr<path_pricer_type>(
+                            new ImportanceSamplingEuropeanPathPricer(
+                                payoff->optionType(),
+                                payoff->strike(),
+                                realProcess->riskFreeRate()->discount(maturity),
+                                drift,
+                                sigma,
+                                maturity,
+                                theta));
+                }
+                return MCEuropeanEngine<RNG,S>::pathPricer();
+            };
             bool ifConst; 
+            bool importanceSampling_;
+            bool localVolGrid_;
+            boost::shared_ptr<ConstResultCache> cache_;
+            Size strata_;
+            bool momentMatching_;
+            mutable boost::shared_ptr<ConstResultCache::Key> lastInputKey_;
+            mutable bool lastRunToppedUp_;
+            mutable ConstSimulationContext<RNG,path_generator_type> context_;
             boost::shared_ptr<GeneralizedBlackScholesProcess> realProcess;      
             bool brownianBridge_;
             BigNatural seed_;      
@@ -104,6 +475,12 @@ namespace QuantLib {
         MakeMCEuropeanConstEngine& withMaxSamples(Size samples);
         MakeMCEuropeanConstEngine& withSeed(BigNatural seed);
         MakeMCEuropeanConstEngine& withAntitheticVariate(bool b = true);
+        MakeMCEuropeanConstEngine& withImportanceSampling(bool b = true);
+        MakeMCEuropeanConstEngine& withLocalVolGrid(bool b = true);
+        MakeMCEuropeanConstEngine& withResultCache(
+                        const boost::shared_ptr<ConstResultCache>& cache);
+        MakeMCEuropeanConstEngine& withStratification(Size strata);
+        MakeMCEuropeanConstEngine& withMomentMatching(bool b = true);
 
         // conversion to pricing engine
         operator boost::shared_ptr<PricingEngine>() const;
@@ -115,6 +492,11 @@ namespace QuantLib {
         bool brownianBridge_;
         BigNatural seed_;
         bool ifConst_;
+        bool importanceSampling_;
+        bool localVolGrid_;
+        boost::shared_ptr<ConstResultCache> cache_;
+        Size strata_;
+        bool momentMatching_;
     };
 
     template <class RNG, class S>
@@ -123,7 +505,9 @@ namespace QuantLib {
     : process_(process), antithetic_(false),
       steps_(Null<Size>()), stepsPerYear_(Null<Size>()),
       samples_(Null<Size>()), maxSamples_(Null<Size>()),
-      tolerance_(Null<Real>()), brownianBridge_(false), seed_(0), ifConst_(ifconst) {}
+      tolerance_(Null<Real>()), brownianBridge_(false), seed_(0), ifConst_(ifconst),
+      importanceSampling_(false), localVolGrid_(false),
+      strata_(1), momentMatching_(false) {}
 
     template <class RNG, class S>
     inline MakeMCEuropeanConstEngine<RNG,S>&
@@ -188,6 +572,42 @@ namespace QuantLib {
         return *this;
     }
 
+    template <class RNG, class S>
+    inline MakeMCEuropeanConstEngine<RNG,S>&
+    MakeMCEuropeanConstEngine<RNG,S>::withImportanceSampling(bool b) {
+        importanceSampling_ = b;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanConstEngine<RNG,S>&
+    MakeMCEuropeanConstEngine<RNG,S>::withLocalVolGrid(bool b) {
+        localVolGrid_ = b;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanConstEngine<RNG,S>&
+    MakeMCEuropeanConstEngine<RNG,S>::withResultCache(
+                        const boost::shared_ptr<ConstResultCache>& cache) {
+        cache_ = cache;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanConstEngine<RNG,S>&
+    MakeMCEuropeanConstEngine<RNG,S>::withStratification(Size strata) {
+        strata_ = strata;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanConstEngine<RNG,S>&
+    MakeMCEuropeanConstEngine<RNG,S>::withMomentMatching(bool b) {
+        momentMatching_ = b;
+        return *this;
+    }
+
     template <class RNG, class S>
     inline
     MakeMCEuropeanConstEngine<RNG,S>::operator boost::shared_ptr<PricingEngine>()
@@ -205,7 +625,12 @@ namespace QuantLib {
                                     samples_, tolerance_,
                                     maxSamples_,
                                     seed_,
-                                    ifConst_));
+                                    ifConst_,
+                                    importanceSampling_,
+                                    localVolGrid_,
+                                    cache_,
+                                    strata_,
+                                    momentMatching_));
     }
 
 }
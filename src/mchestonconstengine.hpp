@@ -0,0 +1,399 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file mchestonconstengine.hpp
+    \brief Monte Carlo European and Asian engines for the const Heston process
+*/
+
+#ifndef quantlib_montecarlo_heston_const_engine_hpp
+#define quantlib_montecarlo_heston_const_engine_hpp
+
+#include <ql/pricingengines/vanilla/mceuropeanhestonengine.hpp>
+#include <ql/instruments/asianoption.hpp>
+#include <ql/pricingengines/mcsimulation.hpp>
+#include <ql/exercise.hpp>
+#include "./hestonconstprocess.hpp"
+#include "./multipathpricers.hpp"
+
+namespace QuantLib {
+
+    //! Monte Carlo European Heston engine with const parameters
+    /*! Same as MCEuropeanHestonEngine, but when ifConst is set the
+        paths are generated by a HestonConstProcess built from the real
+        process at the exercise date.
+    */
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MCEuropeanHestonConstEngine
+        : public MCEuropeanHestonEngine<RNG,S> {
+      public:
+        typedef
+        typename MCVanillaEngine<MultiVariate,RNG,S>::path_generator_type
+            path_generator_type;
+        typedef
+        typename MCVanillaEngine<MultiVariate,RNG,S>::path_pricer_type
+            path_pricer_type;
+        typedef typename MCVanillaEngine<MultiVariate,RNG,S>::stats_type
+            stats_type;
+        // constructor
+        MCEuropeanHestonConstEngine(
+             const boost::shared_ptr<HestonProcess>& process,
+             Size timeSteps,
+             Size timeStepsPerYear,
+             bool antitheticVariate,
+             Size requiredSamples,
+             Real requiredTolerance,
+             Size maxSamples,
+             BigNatural seed,
+             bool ifconst) : MCEuropeanHestonEngine<RNG,S>(
+                 process,
+                 timeSteps,
+                 timeStepsPerYear,
+                 antitheticVariate,
+                 requiredSamples,
+                 requiredTolerance,
+                 maxSamples,
+                 seed),
+                 ifConst(ifconst),
+                 realProcess(process),
+                 seed_(seed){};
+     protected:
+            boost::shared_ptr<path_generator_type> pathGenerator() const {
+                if(ifConst){
+                    Date exercisedate = GenericEngine<OneAssetOption::arguments,OneAssetOption::results>::arguments_.exercise->lastDate();
+                    boost::shared_ptr<HestonConstProcess> constProcess_(
+                        new HestonConstProcess(exercisedate, realProcess));
+
+                    Size dimensions = constProcess_->factors();
+                    TimeGrid grid = this->timeGrid();
+                    constProcess_->prepare(grid);
+                    typename RNG::rsg_type generator =
+                        RNG::make_sequence_generator(dimensions*(grid.size()-1),seed_);
+                    return boost::shared_ptr<path_generator_type>(
+                            new path_generator_type(constProcess_, grid,
+                                                    generator, false));
+                }else{
+                    return MCEuropeanHestonEngine<RNG,S>::pathGenerator();
+                }
+            };
+            bool ifConst;
+            boost::shared_ptr<HestonProcess> realProcess;
+            BigNatural seed_;
+    };
+
+
+    //!  Monte Carlo discrete arithmetic average price Asian Heston engine
+    /*!  Heston counterpart of MCDiscreteArithmeticAPConstEngine. QuantLib
+         has no Heston Asian engine to derive from, so the simulation is
+         set up here the way MCDiscreteAveragingAsianEngine does it, on a
+         multi-variate path. With ifConst the paths come from a
+         HestonConstProcess, otherwise from the real process and its own
+         discretization. No control variate is available.
+
+         \ingroup asianengines
+    */
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MCDiscreteArithmeticAPHestonConstEngine
+        : public DiscreteAveragingAsianOption::engine,
+          public McSimulation<MultiVariate,RNG,S> {
+      public:
+        typedef
+        typename McSimulation<MultiVariate,RNG,S>::path_generator_type
+            path_generator_type;
+        typedef typename McSimulation<MultiVariate,RNG,S>::path_pricer_type
+            path_pricer_type;
+        typedef typename McSimulation<MultiVariate,RNG,S>::stats_type
+            stats_type;
+        // constructor
+        MCDiscreteArithmeticAPHestonConstEngine(
+             const boost::shared_ptr<HestonProcess>& process,
+             bool antitheticVariate,
+             Size requiredSamples,
+             Real requiredTolerance,
+             Size maxSamples,
+             BigNatural seed,
+             bool ifConst)
+        : McSimulation<MultiVariate,RNG,S>(antitheticVariate, false),
+          realProcess(process), requiredSamples_(requiredSamples),
+          maxSamples_(maxSamples), requiredTolerance_(requiredTolerance),
+          seed_(seed), ifconst(ifConst) {
+            registerWith(realProcess);
+        }
+
+        void calculate() const {
+            McSimulation<MultiVariate,RNG,S>::calculate(requiredTolerance_,
+                                                        requiredSamples_,
+                                                        maxSamples_);
+            results_.value = this->mcModel_->sampleAccumulator().mean();
+            if (RNG::allowsErrorEstimate)
+                results_.errorEstimate =
+                    this->mcModel_->sampleAccumulator().errorEstimate();
+        }
+
+      protected:
+        // McSimulation implementation
+        TimeGrid timeGrid() const {
+            std::vector<Time> fixingTimes;
+            for (Size i=0; i<arguments_.fixingDates.size(); i++) {
+                Time t = realProcess->time(arguments_.fixingDates[i]);
+                if (t>=0)
+                    fixingTimes.push_back(t);
+            }
+            return TimeGrid(fixingTimes.begin(), fixingTimes.end());
+        }
+
+        boost::shared_ptr<path_generator_type> pathGenerator() const {
+            TimeGrid grid = this->timeGrid();
+            boost::shared_ptr<StochasticProcess> process = realProcess;
+            if(ifconst){
+                Date exercisedate = arguments_.exercise->lastDate();
+                boost::shared_ptr<HestonConstProcess> constProcess(
+                    new HestonConstProcess(exercisedate, realProcess));
+                constProcess->prepare(grid);
+                process = constProcess;
+            }
+            typename RNG::rsg_type gen =
+                RNG::make_sequence_generator(
+                             process->factors()*(grid.size()-1), seed_);
+            return boost::shared_ptr<path_generator_type>(
+                         new path_generator_type(process, grid, gen, false));
+        }
+
+        boost::shared_ptr<path_pricer_type> pathPricer() const {
+            QL_REQUIRE(arguments_.averageType == Average::Arithmetic,
+                       "arithmetic average required");
+            boost::shared_ptr<PlainVanillaPayoff> payoff =
+                boost::dynamic_pointer_cast<PlainVanillaPayoff>(
+                                                        arguments_.payoff);
+            QL_REQUIRE(payoff, "non-plain payoff given");
+            boost::shared_ptr<EuropeanExercise> exercise =
+                boost::dynamic_pointer_cast<EuropeanExercise>(
+                                                       arguments_.exercise);
+            QL_REQUIRE(exercise, "wrong exercise given");
+
+            return boost::shared_ptr<path_pricer_type>(
+                new ArithmeticAPOMultiPathPricer(
+                    payoff->optionType(),
+                    payoff->strike(),
+                    realProcess->riskFreeRate()->discount(
+                                               this->timeGrid().back()),
+                    arguments_.runningAccumulator,
+                    arguments_.pastFixings));
+        }
+
+      private:
+        boost::shared_ptr<HestonProcess> realProcess;
+        Size requiredSamples_, maxSamples_;
+        Real requiredTolerance_;
+        BigNatural seed_;
+        bool ifconst;
+    };
+
+
+    //! Monte Carlo European Heston const engine factory
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MakeMCEuropeanHestonConstEngine {
+      public:
+        MakeMCEuropeanHestonConstEngine(
+                    const boost::shared_ptr<HestonProcess>&, bool ifconst);
+        // named parameters
+        MakeMCEuropeanHestonConstEngine& withSteps(Size steps);
+        MakeMCEuropeanHestonConstEngine& withStepsPerYear(Size steps);
+        MakeMCEuropeanHestonConstEngine& withSamples(Size samples);
+        MakeMCEuropeanHestonConstEngine& withAbsoluteTolerance(Real tolerance);
+        MakeMCEuropeanHestonConstEngine& withMaxSamples(Size samples);
+        MakeMCEuropeanHestonConstEngine& withSeed(BigNatural seed);
+        MakeMCEuropeanHestonConstEngine& withAntitheticVariate(bool b = true);
+
+        // conversion to pricing engine
+        operator boost::shared_ptr<PricingEngine>() const;
+      private:
+        boost::shared_ptr<HestonProcess> process_;
+        bool antithetic_;
+        Size steps_, stepsPerYear_, samples_, maxSamples_;
+        Real tolerance_;
+        BigNatural seed_;
+        bool ifConst_;
+    };
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanHestonConstEngine<RNG,S>::MakeMCEuropeanHestonConstEngine(
+             const boost::shared_ptr<HestonProcess>& process, bool ifconst)
+    : process_(process), antithetic_(false),
+      steps_(Null<Size>()), stepsPerYear_(Null<Size>()),
+      samples_(Null<Size>()), maxSamples_(Null<Size>()),
+      tolerance_(Null<Real>()), seed_(0), ifConst_(ifconst) {}
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanHestonConstEngine<RNG,S>&
+    MakeMCEuropeanHestonConstEngine<RNG,S>::withSteps(Size steps) {
+        steps_ = steps;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanHestonConstEngine<RNG,S>&
+    MakeMCEuropeanHestonConstEngine<RNG,S>::withStepsPerYear(Size steps) {
+        stepsPerYear_ = steps;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanHestonConstEngine<RNG,S>&
+    MakeMCEuropeanHestonConstEngine<RNG,S>::withSamples(Size samples) {
+        QL_REQUIRE(tolerance_ == Null<Real>(),
+                   "tolerance already set");
+        samples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanHestonConstEngine<RNG,S>&
+    MakeMCEuropeanHestonConstEngine<RNG,S>::withAbsoluteTolerance(Real tolerance) {
+        QL_REQUIRE(samples_ == Null<Size>(),
+                   "number of samples already set");
+        QL_REQUIRE(RNG::allowsErrorEstimate,
+                   "chosen random generator policy "
+                   "does not allow an error estimate");
+        tolerance_ = tolerance;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanHestonConstEngine<RNG,S>&
+    MakeMCEuropeanHestonConstEngine<RNG,S>::withMaxSamples(Size samples) {
+        maxSamples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanHestonConstEngine<RNG,S>&
+    MakeMCEuropeanHestonConstEngine<RNG,S>::withSeed(BigNatural seed) {
+        seed_ = seed;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanHestonConstEngine<RNG,S>&
+    MakeMCEuropeanHestonConstEngine<RNG,S>::withAntitheticVariate(bool b) {
+        antithetic_ = b;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline
+    MakeMCEuropeanHestonConstEngine<RNG,S>::operator boost::shared_ptr<PricingEngine>()
+                                                                      const {
+        QL_REQUIRE(steps_ != Null<Size>() || stepsPerYear_ != Null<Size>(),
+                   "number of steps not given");
+        QL_REQUIRE(steps_ == Null<Size>() || stepsPerYear_ == Null<Size>(),
+                   "number of steps overspecified");
+        return boost::shared_ptr<PricingEngine>(new
+            MCEuropeanHestonConstEngine<RNG,S>(process_,
+                                    steps_,
+                                    stepsPerYear_,
+                                    antithetic_,
+                                    samples_, tolerance_,
+                                    maxSamples_,
+                                    seed_,
+                                    ifConst_));
+    }
+
+
+    //! Monte Carlo discrete arithmetic Asian Heston const engine factory
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MakeMCDiscreteArithmeticAPHestonConstEngine {
+      public:
+        MakeMCDiscreteArithmeticAPHestonConstEngine(
+            const boost::shared_ptr<HestonProcess>& process, bool ifconst);
+        // named parameters
+        MakeMCDiscreteArithmeticAPHestonConstEngine& withSamples(Size samples);
+        MakeMCDiscreteArithmeticAPHestonConstEngine& withAbsoluteTolerance(Real tolerance);
+        MakeMCDiscreteArithmeticAPHestonConstEngine& withMaxSamples(Size samples);
+        MakeMCDiscreteArithmeticAPHestonConstEngine& withSeed(BigNatural seed);
+        MakeMCDiscreteArithmeticAPHestonConstEngine& withAntitheticVariate(bool b = true);
+        // conversion to pricing engine
+        operator boost::shared_ptr<PricingEngine>() const;
+      private:
+        boost::shared_ptr<HestonProcess> process_;
+        bool antithetic_;
+        Size samples_, maxSamples_;
+        Real tolerance_;
+        BigNatural seed_;
+        bool ifconst;
+    };
+
+    template <class RNG, class S>
+    inline
+    MakeMCDiscreteArithmeticAPHestonConstEngine<RNG,S>::MakeMCDiscreteArithmeticAPHestonConstEngine(
+             const boost::shared_ptr<HestonProcess>& process, bool ifConst)
+    : process_(process), antithetic_(false),
+      samples_(Null<Size>()), maxSamples_(Null<Size>()),
+      tolerance_(Null<Real>()), seed_(0), ifconst(ifConst) {}
+
+    template <class RNG, class S>
+    inline MakeMCDiscreteArithmeticAPHestonConstEngine<RNG,S>&
+    MakeMCDiscreteArithmeticAPHestonConstEngine<RNG,S>::withSamples(Size samples) {
+        QL_REQUIRE(tolerance_ == Null<Real>(),
+                   "tolerance already set");
+        samples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCDiscreteArithmeticAPHestonConstEngine<RNG,S>&
+    MakeMCDiscreteArithmeticAPHestonConstEngine<RNG,S>::withAbsoluteTolerance(
+                                                             Real tolerance) {
+        QL_REQUIRE(samples_ == Null<Size>(),
+                   "number of samples already set");
+        QL_REQUIRE(RNG::allowsErrorEstimate,
+                   "chosen random generator policy "
+                   "does not allow an error estimate");
+        tolerance_ = tolerance;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCDiscreteArithmeticAPHestonConstEngine<RNG,S>&
+    MakeMCDiscreteArithmeticAPHestonConstEngine<RNG,S>::withMaxSamples(Size samples) {
+        maxSamples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCDiscreteArithmeticAPHestonConstEngine<RNG,S>&
+    MakeMCDiscreteArithmeticAPHestonConstEngine<RNG,S>::withSeed(BigNatural seed) {
+        seed_ = seed;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCDiscreteArithmeticAPHestonConstEngine<RNG,S>&
+    MakeMCDiscreteArithmeticAPHestonConstEngine<RNG,S>::withAntitheticVariate(bool b) {
+        antithetic_ = b;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline
+    MakeMCDiscreteArithmeticAPHestonConstEngine<RNG,S>::operator boost::shared_ptr<PricingEngine>()
+                                                                      const {
+        return boost::shared_ptr<PricingEngine>(new
+            MCDiscreteArithmeticAPHestonConstEngine<RNG,S>(process_,
+                                                antithetic_,
+                                                samples_, tolerance_,
+                                                maxSamples_,
+                                                seed_,
+                                                ifconst));
+    }
+
+}
+
+
+#endif
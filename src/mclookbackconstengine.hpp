@@ -0,0 +1,518 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file mclookbackconstengine.hpp
+    \brief Monte Carlo lookback engines with const parameters
+*/
+
+#ifndef quantlib_montecarlo_lookback_const_engine_hpp
+#define quantlib_montecarlo_lookback_const_engine_hpp
+
+#include <ql/instruments/lookbackoption.hpp>
+#include <ql/processes/blackscholesprocess.hpp>
+#include <ql/pricingengines/mcsimulation.hpp>
+#include <ql/methods/montecarlo/pathpricer.hpp>
+#include <ql/methods/montecarlo/sample.hpp>
+#include <ql/methods/montecarlo/brownianbridge.hpp>
+#include <ql/math/randomnumbers/inversecumulativersg.hpp>
+#include <ql/timegrid.hpp>
+#include "./blackscholesconstprocess.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace QuantLib {
+
+    namespace detail {
+
+        inline Real lookbackPayoff(
+                      const ContinuousFixedLookbackOption::arguments& args,
+                      Real, Real maximum, Real minimum) {
+            boost::shared_ptr<StrikedTypePayoff> payoff =
+                boost::dynamic_pointer_cast<StrikedTypePayoff>(args.payoff);
+            QL_REQUIRE(payoff, "non-striked payoff given");
+            if (payoff->optionType() == Option::Call)
+                return (*payoff)(std::max(args.minmax, maximum));
+            else
+                return (*payoff)(std::min(args.minmax, minimum));
+        }
+
+        inline Real lookbackPayoff(
+                      const ContinuousFloatingLookbackOption::arguments& args,
+                      Real terminal, Real maximum, Real minimum) {
+            boost::shared_ptr<TypePayoff> payoff =
+                boost::dynamic_pointer_cast<TypePayoff>(args.payoff);
+            QL_REQUIRE(payoff, "non-typed payoff given");
+            if (payoff->optionType() == Option::Call)
+                return terminal - std::min(args.minmax, minimum);
+            else
+                return std::max(args.minmax, maximum) - terminal;
+        }
+
+        // whether the payoff reads the maximum (else the minimum)
+        inline bool lookbackUsesMaximum(
+                      const ContinuousFixedLookbackOption::arguments& args) {
+            boost::shared_ptr<TypePayoff> payoff =
+                boost::dynamic_pointer_cast<TypePayoff>(args.payoff);
+            QL_REQUIRE(payoff, "non-typed payoff given");
+            return payoff->optionType() == Option::Call;
+        }
+
+        inline bool lookbackUsesMaximum(
+                      const ContinuousFloatingLookbackOption::arguments& args) {
+            boost::shared_ptr<TypePayoff> payoff =
+                boost::dynamic_pointer_cast<TypePayoff>(args.payoff);
+            QL_REQUIRE(payoff, "non-typed payoff given");
+            return payoff->optionType() == Option::Put;
+        }
+
+    }
+
+
+    //! terminal value and running extremum of one lookback path
+    struct LookbackPathSummary {
+        Real terminal, extremum;
+    };
+
+    namespace detail {
+
+        // inverse cumulative of a sequence generator policy
+        template <class RSG>
+        struct inverse_cumulative_of;
+
+        template <class USG, class IC>
+        struct inverse_cumulative_of<InverseCumulativeRsg<USG,IC> > {
+            typedef IC type;
+        };
+
+    }
+
+
+    //! lookback path generator keeping only the running extremum
+    /*! Each path is one sequence of the engine's uniform generator:
+        the first n dimensions are turned into the normals of the n
+        steps (through the Brownian bridge if asked), and on frozen
+        parameters the next n are the uniforms of the bridge extrema.
+        No path is stored: the log-spot is carried step by step and
+        only the extremum the payoff needs is kept.
+
+        On frozen parameters the log-spot between two grid points is a
+        Brownian bridge, whose maximum given both ends
+        \f$ x_i, x_{i+1} \f$ is drawn exactly from one uniform \f$ U \f$:
+        \f[ M_i = \frac{1}{2}\left(x_i + x_{i+1} +
+            \sqrt{(x_{i+1}-x_i)^2 - 2\sigma^2\Delta t_i \ln U}\right), \f]
+        and the minimum likewise with the root subtracted; this holds
+        on any grid, uniform or not, and costs a log and a square root
+        per step. On a real process, the process is evolved on the grid
+        and the extremum is taken on the grid.
+
+        The antithetic path flips the normals and keeps the uniforms.
+    */
+    template <class USG, class IC>
+    class LookbackPathGenerator {
+      public:
+        typedef Sample<LookbackPathSummary> sample_type;
+        //! frozen parameters: exact steps and bridge extrema
+        LookbackPathGenerator(
+                    const boost::shared_ptr<BlackScholesConstProcess>& process,
+                    const TimeGrid& grid,
+                    const USG& generator,
+                    const IC& inverse,
+                    bool brownianBridge,
+                    bool maximum)
+        : grid_(grid), generator_(generator), inverse_(inverse),
+          steps_(grid.size()-1), brownianBridge_(brownianBridge),
+          bridge_(grid), maximum_(maximum), correction_(true),
+          x0_(std::log(process->x0())),
+          drift_(steps_), vol_(steps_), bridgeVariance_(steps_),
+          normals_(steps_), increments_(steps_), logUniforms_(steps_),
+          next_(LookbackPathSummary(), 1.0) {
+            QL_REQUIRE(generator_.dimension() == 2*steps_,
+                       "sequence generator dimensionality ("
+                       << generator_.dimension() << ") != 2*timeSteps ("
+                       << steps_ << ")");
+            Volatility sigma = process->diffusion();
+            for (Size i=0; i<steps_; ++i) {
+                drift_[i] = process->drift()*grid.dt(i);
+                vol_[i] = sigma*std::sqrt(grid.dt(i));
+                bridgeVariance_[i] = 2.0*sigma*sigma*grid.dt(i);
+            }
+        }
+        //! real process: evolved on the grid, extremum on the grid
+        LookbackPathGenerator(
+                    const boost::shared_ptr<StochasticProcess1D>& process,
+                    const TimeGrid& grid,
+                    const USG& generator,
+                    const IC& inverse,
+                    bool brownianBridge,
+                    bool maximum)
+        : grid_(grid), generator_(generator), inverse_(inverse),
+          steps_(grid.size()-1), brownianBridge_(brownianBridge),
+          bridge_(grid), maximum_(maximum), correction_(false),
+          process_(process), x0_(process->x0()),
+          normals_(steps_), increments_(steps_),
+          next_(LookbackPathSummary(), 1.0) {
+            QL_REQUIRE(generator_.dimension() == steps_,
+                       "sequence generator dimensionality ("
+                       << generator_.dimension() << ") != timeSteps ("
+                       << steps_ << ")");
+        }
+
+        const sample_type& next() const { return next(false); }
+        const sample_type& antithetic() const { return next(true); }
+        Size size() const { return steps_+1; }
+        const TimeGrid& timeGrid() const { return grid_; }
+
+      private:
+        const sample_type& next(bool antithetic) const {
+            if (!antithetic) {
+                typedef typename USG::sample_type sequence_type;
+                const sequence_type& sequence = generator_.nextSequence();
+                next_.weight = sequence.weight;
+                for (Size i=0; i<steps_; ++i)
+                    normals_[i] = inverse_(sequence.value[i]);
+                if (brownianBridge_)
+                    bridge_.transform(normals_.begin(), normals_.end(),
+                                      increments_.begin());
+                else
+                    std::copy(normals_.begin(), normals_.end(),
+                              increments_.begin());
+                if (correction_)
+                    for (Size i=0; i<steps_; ++i)
+                        logUniforms_[i] = std::log(sequence.value[steps_+i]);
+            }
+            Real flip = antithetic ? -1.0 : 1.0;
+
+            Real x = x0_, extremum = x0_;
+            if (correction_) {
+                Real sign = maximum_ ? 1.0 : -1.0;
+                for (Size i=0; i<steps_; ++i) {
+                    Real y = x + drift_[i] + flip*vol_[i]*increments_[i];
+                    Real d = y - x;
+                    Real e = 0.5*(x + y + sign*std::sqrt(
+                                  d*d - bridgeVariance_[i]*logUniforms_[i]));
+                    extremum = maximum_ ? std::max(extremum, e)
+                                        : std::min(extremum, e);
+                    x = y;
+                }
+                next_.value.terminal = std::exp(x);
+                next_.value.extremum = std::exp(extremum);
+            } else {
+                for (Size i=0; i<steps_; ++i) {
+                    x = process_->evolve(grid_[i], x, grid_.dt(i),
+                                         flip*increments_[i]);
+                    extremum = maximum_ ? std::max(extremum, x)
+                                        : std::min(extremum, x);
+                }
+                next_.value.terminal = x;
+                next_.value.extremum = extremum;
+            }
+            return next_;
+        }
+
+        TimeGrid grid_;
+        mutable USG generator_;
+        IC inverse_;
+        Size steps_;
+        bool brownianBridge_;
+        BrownianBridge bridge_;
+        bool maximum_, correction_;
+        boost::shared_ptr<StochasticProcess1D> process_;
+        // log-spot on frozen parameters, spot on a real process
+        Real x0_;
+        std::vector<Real> drift_, vol_, bridgeVariance_;
+        mutable std::vector<Real> normals_, increments_, logUniforms_;
+        mutable sample_type next_;
+    };
+
+
+    //! Monte Carlo traits for LookbackPathGenerator
+    template <class RNG = PseudoRandom>
+    struct LookbackVariate {
+        typedef RNG rng_traits;
+        typedef LookbackPathSummary path_type;
+        typedef PathPricer<path_type> path_pricer_type;
+        typedef typename RNG::ursg_type ursg_type;
+        typedef typename detail::inverse_cumulative_of<
+                             typename RNG::rsg_type>::type ic_type;
+        typedef LookbackPathGenerator<ursg_type,ic_type> path_generator_type;
+        enum { allowsErrorEstimate = RNG::allowsErrorEstimate };
+    };
+
+
+    //! lookback path pricer on the running extremum
+    template <class I>
+    class LookbackConstPathPricer : public PathPricer<LookbackPathSummary> {
+      public:
+        LookbackConstPathPricer(const typename I::arguments& args,
+                                DiscountFactor discount)
+        : args_(args), discount_(discount) {}
+
+        Real operator()(const LookbackPathSummary& path) const {
+            // only the extremum in use is read by the payoff
+            return detail::lookbackPayoff(args_, path.terminal,
+                                          path.extremum,
+                                          path.extremum) * discount_;
+        }
+      private:
+        typename I::arguments args_;
+        DiscountFactor discount_;
+    };
+
+
+    //! Monte Carlo lookback engine with const parameters
+    /*! Works for ContinuousFixedLookbackOption and
+        ContinuousFloatingLookbackOption. Like
+        MCDiscreteArithmeticAPConstEngine it takes the real process and,
+        when ifConst is set, freezes it in a BlackScholesConstProcess;
+        paths come from LookbackPathGenerator, which keeps only the
+        running extremum and draws exact bridge extrema, so that
+        continuous monitoring is unbiased on coarse grids. Without the
+        flag the real process is evolved on the same grid and the
+        extrema are taken on the grid.
+    */
+    template <class I, class RNG = PseudoRandom, class S = Statistics>
+    class MCLookbackConstEngine : public I::engine,
+                                  public McSimulation<LookbackVariate,RNG,S> {
+      public:
+        typedef
+        typename McSimulation<LookbackVariate,RNG,S>::path_generator_type
+            path_generator_type;
+        typedef
+        typename McSimulation<LookbackVariate,RNG,S>::path_pricer_type
+            path_pricer_type;
+        typedef typename McSimulation<LookbackVariate,RNG,S>::stats_type
+            stats_type;
+        // constructor
+        MCLookbackConstEngine(
+             const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+             Size timeSteps,
+             Size timeStepsPerYear,
+             bool brownianBridge,
+             bool antitheticVariate,
+             Size requiredSamples,
+             Real requiredTolerance,
+             Size maxSamples,
+             BigNatural seed,
+             bool ifconst)
+        : McSimulation<LookbackVariate,RNG,S>(antitheticVariate, false),
+          realProcess(process), timeSteps_(timeSteps),
+          timeStepsPerYear_(timeStepsPerYear),
+          brownianBridge_(brownianBridge),
+          requiredSamples_(requiredSamples),
+          requiredTolerance_(requiredTolerance),
+          maxSamples_(maxSamples), seed_(seed), ifConst(ifconst) {
+            QL_REQUIRE(timeSteps != Null<Size>() ||
+                       timeStepsPerYear != Null<Size>(),
+                       "no time steps provided");
+            QL_REQUIRE(timeSteps == Null<Size>() ||
+                       timeStepsPerYear == Null<Size>(),
+                       "both time steps and time steps per year were provided");
+            this->registerWith(realProcess);
+        }
+
+        void calculate() const {
+            McSimulation<LookbackVariate,RNG,S>::calculate(requiredTolerance_,
+                                                           requiredSamples_,
+                                                           maxSamples_);
+            this->results_.value = this->mcModel_->sampleAccumulator().mean();
+            if (RNG::allowsErrorEstimate)
+                this->results_.errorEstimate =
+                    this->mcModel_->sampleAccumulator().errorEstimate();
+        }
+
+      protected:
+        TimeGrid timeGrid() const {
+            Time residualTime =
+                realProcess->time(this->arguments_.exercise->lastDate());
+            if (timeSteps_ != Null<Size>()) {
+                return TimeGrid(residualTime, timeSteps_);
+            } else {
+                Size steps = static_cast<Size>(timeStepsPerYear_*residualTime);
+                return TimeGrid(residualTime, std::max<Size>(steps, 1));
+            }
+        }
+
+        boost::shared_ptr<BlackScholesConstProcess> constProcess() const {
+            Date exercisedate = this->arguments_.exercise->lastDate();
+            return boost::shared_ptr<BlackScholesConstProcess>(
+                new BlackScholesConstProcess(
+                    exercisedate,
+                    realProcess->stateVariable(),
+                    realProcess->dividendYield(),
+                    realProcess->riskFreeRate(),
+                    realProcess->blackVolatility()
+                ));
+        }
+
+        boost::shared_ptr<path_generator_type> pathGenerator() const {
+            typedef typename LookbackVariate<RNG>::ursg_type ursg_type;
+            typedef typename LookbackVariate<RNG>::ic_type ic_type;
+            TimeGrid grid = timeGrid();
+            Size steps = grid.size()-1;
+            bool maximum = detail::lookbackUsesMaximum(this->arguments_);
+            ic_type inverse = RNG::icInstance ? *RNG::icInstance : ic_type();
+            if (ifConst) {
+                // one more uniform per step for the bridge extremum
+                ursg_type generator(2*steps, seed_);
+                return boost::shared_ptr<path_generator_type>(
+                    new path_generator_type(constProcess(), grid,
+                                            generator, inverse,
+                                            brownianBridge_, maximum));
+            } else {
+                ursg_type generator(steps, seed_);
+                return boost::shared_ptr<path_generator_type>(
+                    new path_generator_type(
+                        boost::shared_ptr<StochasticProcess1D>(realProcess),
+                        grid, generator, inverse,
+                        brownianBridge_, maximum));
+            }
+        }
+
+        boost::shared_ptr<path_pricer_type> pathPricer() const {
+            TimeGrid grid = timeGrid();
+            return boost::shared_ptr<path_pricer_type>(
+                new LookbackConstPathPricer<I>(
+                    this->arguments_,
+                    realProcess->riskFreeRate()->discount(grid.back())));
+        }
+
+        boost::shared_ptr<GeneralizedBlackScholesProcess> realProcess;
+        Size timeSteps_, timeStepsPerYear_;
+        bool brownianBridge_;
+        Size requiredSamples_;
+        Real requiredTolerance_;
+        Size maxSamples_;
+        BigNatural seed_;
+        bool ifConst;
+    };
+
+    //! Monte Carlo lookback const engine factory
+    template <class I, class RNG = PseudoRandom, class S = Statistics>
+    class MakeMCLookbackConstEngine {
+      public:
+        MakeMCLookbackConstEngine(
+                    const boost::shared_ptr<GeneralizedBlackScholesProcess>&, bool ifconst);
+        // named parameters
+        MakeMCLookbackConstEngine& withSteps(Size steps);
+        MakeMCLookbackConstEngine& withStepsPerYear(Size steps);
+        MakeMCLookbackConstEngine& withBrownianBridge(bool b = true);
+        MakeMCLookbackConstEngine& withSamples(Size samples);
+        MakeMCLookbackConstEngine& withAbsoluteTolerance(Real tolerance);
+        MakeMCLookbackConstEngine& withMaxSamples(Size samples);
+        MakeMCLookbackConstEngine& withSeed(BigNatural seed);
+        MakeMCLookbackConstEngine& withAntitheticVariate(bool b = true);
+
+        // conversion to pricing engine
+        operator boost::shared_ptr<PricingEngine>() const;
+      private:
+        boost::shared_ptr<GeneralizedBlackScholesProcess> process_;
+        bool antithetic_;
+        Size steps_, stepsPerYear_, samples_, maxSamples_;
+        Real tolerance_;
+        bool brownianBridge_;
+        BigNatural seed_;
+        bool ifConst_;
+    };
+
+    template <class I, class RNG, class S>
+    inline MakeMCLookbackConstEngine<I,RNG,S>::MakeMCLookbackConstEngine(
+             const boost::shared_ptr<GeneralizedBlackScholesProcess>& process, bool ifconst)
+    : process_(process), antithetic_(false),
+      steps_(Null<Size>()), stepsPerYear_(Null<Size>()),
+      samples_(Null<Size>()), maxSamples_(Null<Size>()),
+      tolerance_(Null<Real>()), brownianBridge_(false), seed_(0), ifConst_(ifconst) {}
+
+    template <class I, class RNG, class S>
+    inline MakeMCLookbackConstEngine<I,RNG,S>&
+    MakeMCLookbackConstEngine<I,RNG,S>::withSteps(Size steps) {
+        steps_ = steps;
+        return *this;
+    }
+
+    template <class I, class RNG, class S>
+    inline MakeMCLookbackConstEngine<I,RNG,S>&
+    MakeMCLookbackConstEngine<I,RNG,S>::withStepsPerYear(Size steps) {
+        stepsPerYear_ = steps;
+        return *this;
+    }
+
+    template <class I, class RNG, class S>
+    inline MakeMCLookbackConstEngine<I,RNG,S>&
+    MakeMCLookbackConstEngine<I,RNG,S>::withSamples(Size samples) {
+        QL_REQUIRE(tolerance_ == Null<Real>(),
+                   "tolerance already set");
+        samples_ = samples;
+        return *this;
+    }
+
+    template <class I, class RNG, class S>
+    inline MakeMCLookbackConstEngine<I,RNG,S>&
+    MakeMCLookbackConstEngine<I,RNG,S>::withAbsoluteTolerance(Real tolerance) {
+        QL_REQUIRE(samples_ == Null<Size>(),
+                   "number of samples already set");
+        QL_REQUIRE(RNG::allowsErrorEstimate,
+                   "chosen random generator policy "
+                   "does not allow an error estimate");
+        tolerance_ = tolerance;
+        return *this;
+    }
+
+    template <class I, class RNG, class S>
+    inline MakeMCLookbackConstEngine<I,RNG,S>&
+    MakeMCLookbackConstEngine<I,RNG,S>::withMaxSamples(Size samples) {
+        maxSamples_ = samples;
+        return *this;
+    }
+
+    template <class I, class RNG, class S>
+    inline MakeMCLookbackConstEngine<I,RNG,S>&
+    MakeMCLookbackConstEngine<I,RNG,S>::withSeed(BigNatural seed) {
+        seed_ = seed;
+        return *this;
+    }
+
+    template <class I, class RNG, class S>
+    inline MakeMCLookbackConstEngine<I,RNG,S>&
+    MakeMCLookbackConstEngine<I,RNG,S>::withBrownianBridge(bool brownianBridge) {
+        brownianBridge_ = brownianBridge;
+        return *this;
+    }
+
+    template <class I, class RNG, class S>
+    inline MakeMCLookbackConstEngine<I,RNG,S>&
+    MakeMCLookbackConstEngine<I,RNG,S>::withAntitheticVariate(bool b) {
+        antithetic_ = b;
+        return *this;
+    }
+
+    template <class I, class RNG, class S>
+    inline
+    MakeMCLookbackConstEngine<I,RNG,S>::operator boost::shared_ptr<PricingEngine>()
+                                                                      const {
+        QL_REQUIRE(steps_ != Null<Size>() || stepsPerYear_ != Null<Size>(),
+                   "number of steps not given");
+        QL_REQUIRE(steps_ == Null<Size>() || stepsPerYear_ == Null<Size>(),
+                   "number of steps overspecified");
+        return boost::shared_ptr<PricingEngine>(new
+            MCLookbackConstEngine<I,RNG,S>(process_,
+                                    steps_,
+                                    stepsPerYear_,
+                                    brownianBridge_,
+                                    antithetic_,
+                                    samples_, tolerance_,
+                                    maxSamples_,
+                                    seed_,
+                                    ifConst_));
+    }
+
+}
+
+
+#endif
@@ -0,0 +1,420 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file mcmertonconstengine.hpp
+    \brief Monte Carlo European and Asian engines for the const Merton process
+*/
+
+#ifndef quantlib_montecarlo_merton_const_engine_hpp
+#define quantlib_montecarlo_merton_const_engine_hpp
+
+#include <ql/pricingengines/vanilla/mcvanillaengine.hpp>
+#include <ql/instruments/asianoption.hpp>
+#include <ql/pricingengines/mcsimulation.hpp>
+#include <ql/exercise.hpp>
+#include "./mertonconstprocess.hpp"
+#include "./multipathpricers.hpp"
+
+namespace QuantLib {
+
+    namespace detail {
+
+        inline Time mertonTime(const boost::shared_ptr<Merton76Process>& p,
+                               const Date& d) {
+            return p->riskFreeRate()->dayCounter().yearFraction(
+                                       p->riskFreeRate()->referenceDate(), d);
+        }
+
+    }
+
+    //! Monte Carlo European engine for the Merton jump-diffusion
+    /*! Paths are always generated by a MertonConstProcess built from
+        the real process at the exercise date: Merton76Process has no
+        Monte Carlo discretization of its own, so unlike
+        MCEuropeanConstEngine there is no ifConst switch. The jump
+        tables are built for the engine's time grid before the first
+        path is drawn.
+    */
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MCEuropeanMertonConstEngine
+        : public MCVanillaEngine<MultiVariate,RNG,S> {
+      public:
+        typedef
+        typename MCVanillaEngine<MultiVariate,RNG,S>::path_generator_type
+            path_generator_type;
+        typedef
+        typename MCVanillaEngine<MultiVariate,RNG,S>::path_pricer_type
+            path_pricer_type;
+        typedef typename MCVanillaEngine<MultiVariate,RNG,S>::stats_type
+            stats_type;
+        // constructor
+        MCEuropeanMertonConstEngine(
+             const boost::shared_ptr<Merton76Process>& process,
+             Size timeSteps,
+             Size timeStepsPerYear,
+             bool antitheticVariate,
+             Size requiredSamples,
+             Real requiredTolerance,
+             Size maxSamples,
+             BigNatural seed) : MCVanillaEngine<MultiVariate,RNG,S>(
+                 process,
+                 timeSteps,
+                 timeStepsPerYear,
+                 false,
+                 antitheticVariate,
+                 false,
+                 requiredSamples,
+                 requiredTolerance,
+                 maxSamples,
+                 seed),
+                 realProcess(process),
+                 seed_(seed){};
+     protected:
+            TimeGrid timeGrid() const {
+                Date lastExerciseDate = this->arguments_.exercise->lastDate();
+                Time t = detail::mertonTime(realProcess, lastExerciseDate);
+                if (this->timeSteps_ != Null<Size>()) {
+                    return TimeGrid(t, this->timeSteps_);
+                } else {
+                    Size steps = static_cast<Size>(this->timeStepsPerYear_*t);
+                    return TimeGrid(t, std::max<Size>(steps, 1));
+                }
+            }
+
+            boost::shared_ptr<path_generator_type> pathGenerator() const {
+                Date exercisedate = this->arguments_.exercise->lastDate();
+                boost::shared_ptr<MertonConstProcess> constProcess_(
+                    new MertonConstProcess(exercisedate, realProcess));
+
+                TimeGrid grid = this->timeGrid();
+                constProcess_->prepare(grid);
+                Size dimensions = constProcess_->factors();
+                typename RNG::rsg_type generator =
+                    RNG::make_sequence_generator(dimensions*(grid.size()-1),seed_);
+                return boost::shared_ptr<path_generator_type>(
+                        new path_generator_type(constProcess_, grid,
+                                                generator, false));
+            };
+
+            boost::shared_ptr<path_pricer_type> pathPricer() const {
+                boost::shared_ptr<PlainVanillaPayoff> payoff =
+                    boost::dynamic_pointer_cast<PlainVanillaPayoff>(
+                                                  this->arguments_.payoff);
+                QL_REQUIRE(payoff, "non-plain payoff given");
+                return boost::shared_ptr<path_pricer_type>(
+                    new EuropeanConstMultiPathPricer(
+                        payoff->optionType(),
+                        payoff->strike(),
+                        realProcess->riskFreeRate()->discount(
+                                                this->timeGrid().back())));
+            };
+            boost::shared_ptr<Merton76Process> realProcess;
+            BigNatural seed_;
+    };
+
+
+    //!  Monte Carlo discrete arithmetic average price Asian Merton engine
+    /*!  Jump-diffusion counterpart of MCDiscreteArithmeticAPConstEngine,
+         set up like MCDiscreteArithmeticAPHestonConstEngine on a
+         multi-variate path with one asset and three factors per step.
+
+         \ingroup asianengines
+    */
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MCDiscreteArithmeticAPMertonConstEngine
+        : public DiscreteAveragingAsianOption::engine,
+          public McSimulation<MultiVariate,RNG,S> {
+      public:
+        typedef
+        typename McSimulation<MultiVariate,RNG,S>::path_generator_type
+            path_generator_type;
+        typedef typename McSimulation<MultiVariate,RNG,S>::path_pricer_type
+            path_pricer_type;
+        typedef typename McSimulation<MultiVariate,RNG,S>::stats_type
+            stats_type;
+        // constructor
+        MCDiscreteArithmeticAPMertonConstEngine(
+             const boost::shared_ptr<Merton76Process>& process,
+             bool antitheticVariate,
+             Size requiredSamples,
+             Real requiredTolerance,
+             Size maxSamples,
+             BigNatural seed)
+        : McSimulation<MultiVariate,RNG,S>(antitheticVariate, false),
+          realProcess(process), requiredSamples_(requiredSamples),
+          maxSamples_(maxSamples), requiredTolerance_(requiredTolerance),
+          seed_(seed) {
+            registerWith(realProcess);
+        }
+
+        void calculate() const {
+            McSimulation<MultiVariate,RNG,S>::calculate(requiredTolerance_,
+                                                        requiredSamples_,
+                                                        maxSamples_);
+            results_.value = this->mcModel_->sampleAccumulator().mean();
+            if (RNG::allowsErrorEstimate)
+                results_.errorEstimate =
+                    this->mcModel_->sampleAccumulator().errorEstimate();
+        }
+
+      protected:
+        // McSimulation implementation
+        TimeGrid timeGrid() const {
+            std::vector<Time> fixingTimes;
+            for (Size i=0; i<arguments_.fixingDates.size(); i++) {
+                Time t = detail::mertonTime(realProcess,
+                                            arguments_.fixingDates[i]);
+                if (t>=0)
+                    fixingTimes.push_back(t);
+            }
+            return TimeGrid(fixingTimes.begin(), fixingTimes.end());
+        }
+
+        boost::shared_ptr<path_generator_type> pathGenerator() const {
+            Date exercisedate = arguments_.exercise->lastDate();
+            boost::shared_ptr<MertonConstProcess> constProcess_(
+                new MertonConstProcess(exercisedate, realProcess));
+
+            TimeGrid grid = this->timeGrid();
+            constProcess_->prepare(grid);
+            typename RNG::rsg_type gen =
+                RNG::make_sequence_generator(
+                       constProcess_->factors()*(grid.size()-1), seed_);
+            return boost::shared_ptr<path_generator_type>(
+                  new path_generator_type(constProcess_, grid, gen, false));
+        }
+
+        boost::shared_ptr<path_pricer_type> pathPricer() const {
+            QL_REQUIRE(arguments_.averageType == Average::Arithmetic,
+                       "arithmetic average required");
+            boost::shared_ptr<PlainVanillaPayoff> payoff =
+                boost::dynamic_pointer_cast<PlainVanillaPayoff>(
+                                                        arguments_.payoff);
+            QL_REQUIRE(payoff, "non-plain payoff given");
+            boost::shared_ptr<EuropeanExercise> exercise =
+                boost::dynamic_pointer_cast<EuropeanExercise>(
+                                                       arguments_.exercise);
+            QL_REQUIRE(exercise, "wrong exercise given");
+
+            return boost::shared_ptr<path_pricer_type>(
+                new ArithmeticAPOMultiPathPricer(
+                    payoff->optionType(),
+                    payoff->strike(),
+                    realProcess->riskFreeRate()->discount(
+                                               this->timeGrid().back()),
+                    arguments_.runningAccumulator,
+                    arguments_.pastFixings));
+        }
+
+      private:
+        boost::shared_ptr<Merton76Process> realProcess;
+        Size requiredSamples_, maxSamples_;
+        Real requiredTolerance_;
+        BigNatural seed_;
+    };
+
+
+    //! Monte Carlo European Merton const engine factory
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MakeMCEuropeanMertonConstEngine {
+      public:
+        MakeMCEuropeanMertonConstEngine(
+                    const boost::shared_ptr<Merton76Process>&);
+        // named parameters
+        MakeMCEuropeanMertonConstEngine& withSteps(Size steps);
+        MakeMCEuropeanMertonConstEngine& withStepsPerYear(Size steps);
+        MakeMCEuropeanMertonConstEngine& withSamples(Size samples);
+        MakeMCEuropeanMertonConstEngine& withAbsoluteTolerance(Real tolerance);
+        MakeMCEuropeanMertonConstEngine& withMaxSamples(Size samples);
+        MakeMCEuropeanMertonConstEngine& withSeed(BigNatural seed);
+        MakeMCEuropeanMertonConstEngine& withAntitheticVariate(bool b = true);
+
+        // conversion to pricing engine
+        operator boost::shared_ptr<PricingEngine>() const;
+      private:
+        boost::shared_ptr<Merton76Process> process_;
+        bool antithetic_;
+        Size steps_, stepsPerYear_, samples_, maxSamples_;
+        Real tolerance_;
+        BigNatural seed_;
+    };
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanMertonConstEngine<RNG,S>::MakeMCEuropeanMertonConstEngine(
+             const boost::shared_ptr<Merton76Process>& process)
+    : process_(process), antithetic_(false),
+      steps_(Null<Size>()), stepsPerYear_(Null<Size>()),
+      samples_(Null<Size>()), maxSamples_(Null<Size>()),
+      tolerance_(Null<Real>()), seed_(0) {}
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanMertonConstEngine<RNG,S>&
+    MakeMCEuropeanMertonConstEngine<RNG,S>::withSteps(Size steps) {
+        steps_ = steps;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanMertonConstEngine<RNG,S>&
+    MakeMCEuropeanMertonConstEngine<RNG,S>::withStepsPerYear(Size steps) {
+        stepsPerYear_ = steps;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanMertonConstEngine<RNG,S>&
+    MakeMCEuropeanMertonConstEngine<RNG,S>::withSamples(Size samples) {
+        QL_REQUIRE(tolerance_ == Null<Real>(),
+                   "tolerance already set");
+        samples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanMertonConstEngine<RNG,S>&
+    MakeMCEuropeanMertonConstEngine<RNG,S>::withAbsoluteTolerance(Real tolerance) {
+        QL_REQUIRE(samples_ == Null<Size>(),
+                   "number of samples already set");
+        QL_REQUIRE(RNG::allowsErrorEstimate,
+                   "chosen random generator policy "
+                   "does not allow an error estimate");
+        tolerance_ = tolerance;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanMertonConstEngine<RNG,S>&
+    MakeMCEuropeanMertonConstEngine<RNG,S>::withMaxSamples(Size samples) {
+        maxSamples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanMertonConstEngine<RNG,S>&
+    MakeMCEuropeanMertonConstEngine<RNG,S>::withSeed(BigNatural seed) {
+        seed_ = seed;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCEuropeanMertonConstEngine<RNG,S>&
+    MakeMCEuropeanMertonConstEngine<RNG,S>::withAntitheticVariate(bool b) {
+        antithetic_ = b;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline
+    MakeMCEuropeanMertonConstEngine<RNG,S>::operator boost::shared_ptr<PricingEngine>()
+                                                                      const {
+        QL_REQUIRE(steps_ != Null<Size>() || stepsPerYear_ != Null<Size>(),
+                   "number of steps not given");
+        QL_REQUIRE(steps_ == Null<Size>() || stepsPerYear_ == Null<Size>(),
+                   "number of steps overspecified");
+        return boost::shared_ptr<PricingEngine>(new
+            MCEuropeanMertonConstEngine<RNG,S>(process_,
+                                    steps_,
+                                    stepsPerYear_,
+                                    antithetic_,
+                                    samples_, tolerance_,
+                                    maxSamples_,
+                                    seed_));
+    }
+
+
+    //! Monte Carlo discrete arithmetic Asian Merton const engine factory
+    template <class RNG = PseudoRandom, class S = Statistics>
+    class MakeMCDiscreteArithmeticAPMertonConstEngine {
+      public:
+        MakeMCDiscreteArithmeticAPMertonConstEngine(
+            const boost::shared_ptr<Merton76Process>& process);
+        // named parameters
+        MakeMCDiscreteArithmeticAPMertonConstEngine& withSamples(Size samples);
+        MakeMCDiscreteArithmeticAPMertonConstEngine& withAbsoluteTolerance(Real tolerance);
+        MakeMCDiscreteArithmeticAPMertonConstEngine& withMaxSamples(Size samples);
+        MakeMCDiscreteArithmeticAPMertonConstEngine& withSeed(BigNatural seed);
+        MakeMCDiscreteArithmeticAPMertonConstEngine& withAntitheticVariate(bool b = true);
+        // conversion to pricing engine
+        operator boost::shared_ptr<PricingEngine>() const;
+      private:
+        boost::shared_ptr<Merton76Process> process_;
+        bool antithetic_;
+        Size samples_, maxSamples_;
+        Real tolerance_;
+        BigNatural seed_;
+    };
+
+    template <class RNG, class S>
+    inline
+    MakeMCDiscreteArithmeticAPMertonConstEngine<RNG,S>::MakeMCDiscreteArithmeticAPMertonConstEngine(
+             const boost::shared_ptr<Merton76Process>& process)
+    : process_(process), antithetic_(false),
+      samples_(Null<Size>()), maxSamples_(Null<Size>()),
+      tolerance_(Null<Real>()), seed_(0) {}
+
+    template <class RNG, class S>
+    inline MakeMCDiscreteArithmeticAPMertonConstEngine<RNG,S>&
+    MakeMCDiscreteArithmeticAPMertonConstEngine<RNG,S>::withSamples(Size samples) {
+        QL_REQUIRE(tolerance_ == Null<Real>(),
+                   "tolerance already set");
+        samples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCDiscreteArithmeticAPMertonConstEngine<RNG,S>&
+    MakeMCDiscreteArithmeticAPMertonConstEngine<RNG,S>::withAbsoluteTolerance(
+                                                             Real tolerance) {
+        QL_REQUIRE(samples_ == Null<Size>(),
+                   "number of samples already set");
+        QL_REQUIRE(RNG::allowsErrorEstimate,
+                   "chosen random generator policy "
+                   "does not allow an error estimate");
+        tolerance_ = tolerance;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCDiscreteArithmeticAPMertonConstEngine<RNG,S>&
+    MakeMCDiscreteArithmeticAPMertonConstEngine<RNG,S>::withMaxSamples(Size samples) {
+        maxSamples_ = samples;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCDiscreteArithmeticAPMertonConstEngine<RNG,S>&
+    MakeMCDiscreteArithmeticAPMertonConstEngine<RNG,S>::withSeed(BigNatural seed) {
+        seed_ = seed;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline MakeMCDiscreteArithmeticAPMertonConstEngine<RNG,S>&
+    MakeMCDiscreteArithmeticAPMertonConstEngine<RNG,S>::withAntitheticVariate(bool b) {
+        antithetic_ = b;
+        return *this;
+    }
+
+    template <class RNG, class S>
+    inline
+    MakeMCDiscreteArithmeticAPMertonConstEngine<RNG,S>::operator boost::shared_ptr<PricingEngine>()
+                                                                      const {
+        return boost::shared_ptr<PricingEngine>(new
+            MCDiscreteArithmeticAPMertonConstEngine<RNG,S>(process_,
+                                                antithetic_,
+                                                samples_, tolerance_,
+                                                maxSamples_,
+                                                seed_));
+    }
+
+}
+
+
+#endif
@@ -0,0 +1,203 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "./mertonconstprocess.hpp"
+#include <ql/math/distributions/normaldistribution.hpp>
+#include <algorithm>
+#include <math.h>
+
+
+namespace QuantLib {
+
+    namespace {
+
+        // the Poisson tail beyond this is dropped from the table; a
+        // step whose tail is still larger after maxJumpsPerStep jumps
+        // is rejected
+        const Real jumpTailProbability = 1.0e-12;
+        const Size maxJumpsPerStep = 50;
+
+    }
+
+    MertonConstProcess::MertonConstProcess(
+                        const Date& exercisedate,
+                        const boost::shared_ptr<Merton76Process>& process)
+    : x0_(process->stateVariable()), riskFreeRate_(process->riskFreeRate()),
+      lambda_(process->jumpIntensity()->value()),
+      muJ_(process->logMeanJump()->value()),
+      sigmaJ_(process->logJumpVolatility()->value()), cursor_(0) {
+
+        QL_REQUIRE(lambda_ >= 0.0, "negative jump intensity given");
+        QL_REQUIRE(sigmaJ_ >= 0.0, "negative jump volatility given");
+
+        Time dt = time(exercisedate);
+        riskFreeForward_ = process->riskFreeRate()->zeroRate(
+                                        dt, Continuous, NoFrequency, true);
+        dividendForward_ = process->dividendYield()->zeroRate(
+                                        dt, Continuous, NoFrequency, true);
+        sigma_ = process->blackVolatility()->blackVol(
+                                        dt, x0_->value(), true);
+
+        Real compensator = lambda_*(std::exp(muJ_ + 0.5*sigmaJ_*sigmaJ_) - 1.0);
+        drift_ = riskFreeForward_ - dividendForward_
+               - 0.5*sigma_*sigma_ - compensator;
+        offGrid_.dt = -1.0;
+    }
+
+    Size MertonConstProcess::size() const {
+        return 1;
+    }
+
+    Size MertonConstProcess::factors() const {
+        return 3;
+    }
+
+    Disposable<Array> MertonConstProcess::initialValues() const {
+        Array tmp(1, x0_->value());
+        return tmp;
+    }
+
+    Disposable<Array> MertonConstProcess::drift(Time, const Array&) const {
+        // drift of the log, continuous part only
+        Array tmp(1, drift_);
+        return tmp;
+    }
+
+    Disposable<Matrix> MertonConstProcess::diffusion(Time,
+                                                     const Array&) const {
+        Matrix tmp(1, 3, 0.0);
+        tmp[0][0] = sigma_;
+        return tmp;
+    }
+
+    Disposable<Array> MertonConstProcess::apply(const Array& x0,
+                                                const Array& dx) const {
+        Array tmp(1, x0[0] * std::exp(dx[0]));
+        return tmp;
+    }
+
+    void MertonConstProcess::prepare(const TimeGrid& grid) const {
+        Size n = grid.size() > 0 ? grid.size()-1 : 0;
+        tables_.clear();
+        times_.resize(n);
+        stepTables_.resize(n);
+        for (Size i=0; i<n; ++i) {
+            times_[i] = grid[i];
+            Time dt = grid.dt(i);
+            // steps of the same length share their table
+            Size k = 0;
+            while (k < tables_.size() && tables_[k].dt != dt)
+                ++k;
+            if (k == tables_.size()) {
+                tables_.push_back(JumpTable());
+                computeTable(dt, tables_.back());
+            }
+            stepTables_[i] = k;
+        }
+        cursor_ = 0;
+    }
+
+    void MertonConstProcess::computeTable(Time dt, JumpTable& t) const {
+        t.dt = dt;
+        t.driftDt = drift_*dt;
+        t.sigmaSqrtDt = sigma_*std::sqrt(dt);
+        t.thresholds.clear();
+        t.jumpMean.assign(1, 0.0);
+        t.jumpStdDev.assign(1, 0.0);
+
+        InverseCumulativeNormal invNormal;
+        Real lambdaDt = lambda_*dt;
+        Real p = std::exp(-lambdaDt);
+        Real cumulated = p;
+        Size n = 1;
+        for (; n<=maxJumpsPerStep
+               && 1.0-cumulated > jumpTailProbability; ++n) {
+            t.thresholds.push_back(invNormal(cumulated));
+            p *= lambdaDt/n;
+            cumulated += p;
+            t.jumpMean.push_back(n*muJ_);
+            t.jumpStdDev.push_back(std::sqrt(Real(n))*sigmaJ_);
+        }
+        QL_REQUIRE(1.0-cumulated <= jumpTailProbability,
+                   "jump intensity times step (" << lambdaDt
+                   << ") too large: more than " << maxJumpsPerStep
+                   << " jumps per step have probability "
+                   << 1.0-cumulated << "; use smaller steps");
+    }
+
+    const MertonConstProcess::JumpTable&
+    MertonConstProcess::table(Time t0, Time dt) const {
+        // path generators walk the grid in order: try the current and
+        // the next step before searching
+        Size i = cursor_;
+        if (!(i < times_.size() && times_[i] == t0)) {
+            if (i+1 < times_.size() && times_[i+1] == t0)
+                ++i;
+            else
+                i = std::lower_bound(times_.begin(), times_.end(), t0)
+                  - times_.begin();
+        }
+        if (i < times_.size() && times_[i] == t0 &&
+            tables_[stepTables_[i]].dt == dt) {
+            cursor_ = i;
+            return tables_[stepTables_[i]];
+        }
+        if (dt != offGrid_.dt)
+            computeTable(dt, offGrid_);
+        return offGrid_;
+    }
+
+    Disposable<Array> MertonConstProcess::evolve(Time t0, const Array& x0,
+                                                 Time dt,
+                                                 const Array& dw) const {
+        const JumpTable& t = table(t0, dt);
+        Size n = 0;
+        while (n < t.thresholds.size() && dw[1] > t.thresholds[n])
+            ++n;
+        Real dx = t.driftDt + t.sigmaSqrtDt*dw[0]
+                + t.jumpMean[n] + t.jumpStdDev[n]*dw[2];
+        Array tmp(1, x0[0] * std::exp(dx));
+        return tmp;
+    }
+
+    Time MertonConstProcess::time(const Date& d) const {
+        return riskFreeRate_->dayCounter().yearFraction(
+                                           riskFreeRate_->referenceDate(), d);
+    }
+
+    Real MertonConstProcess::x0() const {
+        return x0_->value();
+    }
+
+    Rate MertonConstProcess::riskFreeForward() const {
+        return riskFreeForward_;
+    }
+
+    Rate MertonConstProcess::dividendForward() const {
+        return dividendForward_;
+    }
+
+    Volatility MertonConstProcess::volatility() const {
+        return sigma_;
+    }
+
+    Real MertonConstProcess::jumpIntensity() const {
+        return lambda_;
+    }
+
+    Real MertonConstProcess::logMeanJump() const {
+        return muJ_;
+    }
+
+    Real MertonConstProcess::logJumpVolatility() const {
+        return sigmaJ_;
+    }
+
+}
@@ -0,0 +1,114 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file mertonconstprocess.hpp
+    \brief Merton (1976) jump-diffusion process with const parameters
+*/
+
+#ifndef quantlib_merton_const_process_hpp
+#define quantlib_merton_const_process_hpp
+
+#include <ql/stochasticprocess.hpp>
+#include <ql/processes/merton76process.hpp>
+#include <ql/timegrid.hpp>
+#include <vector>
+
+namespace QuantLib {
+
+    //! Merton jump-diffusion process with frozen parameters
+    /*! r, q and sigma are frozen at the exercise date as in
+        BlackScholesConstProcess; the jump intensity and the log-jump
+        mean and volatility are read once from their quotes. The state
+        is the underlying; each step takes three normal draws:
+
+        - dw[0] drives the diffusion,
+        - dw[1] selects the number of jumps in the step,
+        - dw[2] draws the sum of the log-jump sizes.
+
+        For each step the Poisson distribution of the number of jumps
+        is precomputed as thresholds in normal space,
+        \f$ z_n = \Phi^{-1}(P(N \le n)) \f$, so that the number of jumps
+        is found by comparing dw[1] with the thresholds, and the mean
+        and standard deviation of a sum of n log-jumps are tabulated as
+        well. A step is then a couple of comparisons, two multiply-adds
+        and the final exponential. The compensator
+        \f$ \lambda(e^{\mu_J+\sigma_J^2/2}-1) \f$ is folded into the
+        drift.
+
+        prepare() builds the tables once per run for the steps of a
+        TimeGrid (steps of equal length share one), and evolve() finds
+        the table of its step by start time, with a cursor that follows
+        the path forward; a step off the prepared grid is tabulated on
+        the fly. The Poisson tail is dropped below 1e-12, with at most
+        50 jumps per step; a step where 50 jumps do not reach that is
+        rejected, and must be split.
+
+        The cursor and the off-grid table are mutable state: a process
+        must not be used by several threads at once.
+    */
+    class MertonConstProcess : public StochasticProcess {
+      public:
+        MertonConstProcess(const Date& exercisedate,
+                           const boost::shared_ptr<Merton76Process>& process);
+
+        Size size() const;
+        Size factors() const;
+
+        Disposable<Array> initialValues() const;
+        Disposable<Array> drift(Time t, const Array& x) const;
+        Disposable<Matrix> diffusion(Time t, const Array& x) const;
+
+        Disposable<Array> apply(const Array& x0, const Array& dx) const;
+        Disposable<Array> evolve(Time t0, const Array& x0,
+                                 Time dt, const Array& dw) const;
+
+        Time time(const Date&) const;
+
+        //! tabulates the jump distribution for every step of the grid
+        void prepare(const TimeGrid& grid) const;
+
+        Real x0() const;
+        Rate riskFreeForward() const;
+        Rate dividendForward() const;
+        Volatility volatility() const;
+        Real jumpIntensity() const;
+        Real logMeanJump() const;
+        Real logJumpVolatility() const;
+
+      private:
+        struct JumpTable {
+            Time dt;
+            Real driftDt, sigmaSqrtDt;
+            // thresholds[n] = InverseCumulativeNormal(P(N <= n))
+            std::vector<Real> thresholds;
+            // mean and std deviation of the sum of n log-jumps
+            std::vector<Real> jumpMean, jumpStdDev;
+        };
+        void computeTable(Time dt, JumpTable& table) const;
+        const JumpTable& table(Time t0, Time dt) const;
+
+        Handle<Quote> x0_;
+        Handle<YieldTermStructure> riskFreeRate_;
+        Rate riskFreeForward_, dividendForward_;
+        Volatility sigma_;
+        Real lambda_, muJ_, sigmaJ_;
+        Real drift_;
+        // tables of the prepared grid, and the table of each step
+        mutable std::vector<JumpTable> tables_;
+        mutable std::vector<Time> times_;
+        mutable std::vector<Size> stepTables_;
+        mutable Size cursor_;
+        mutable JumpTable offGrid_;
+    };
+
+}
+
+
+#endif
@@ -0,0 +1,93 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file multipathpricers.hpp
+    \brief path pricers on the first asset of a multi-path
+*/
+
+#ifndef quantlib_const_multi_path_pricers_hpp
+#define quantlib_const_multi_path_pricers_hpp
+
+#include <ql/methods/montecarlo/pathpricer.hpp>
+#include <ql/methods/montecarlo/multipath.hpp>
+#include <ql/instruments/payoffs.hpp>
+#include <numeric>
+
+namespace QuantLib {
+
+    //! European pricer on the first asset of a multi-path
+    /*! Not QuantLib's EuropeanMultiPathPricer, which prices a basket
+        payoff on all the assets. */
+    class EuropeanConstMultiPathPricer : public PathPricer<MultiPath> {
+      public:
+        EuropeanConstMultiPathPricer(Option::Type type,
+                                     Real strike,
+                                     DiscountFactor discount)
+        : payoff_(type, strike), discount_(discount) {
+            QL_REQUIRE(strike>=0.0,
+                       "strike less than zero not allowed");
+        }
+
+        Real operator()(const MultiPath& multiPath) const {
+            const Path& path = multiPath[0];
+            QL_REQUIRE(path.length() > 0, "the path cannot be empty");
+            return payoff_(path.back()) * discount_;
+        }
+      private:
+        PlainVanillaPayoff payoff_;
+        DiscountFactor discount_;
+    };
+
+    //! arithmetic average price pricer on the first asset of a multi-path
+    /*! Same payoff as ArithmeticAPOPathPricer, for processes such as
+        Heston whose paths carry more than the underlying, or which
+        need more than one factor per step. */
+    class ArithmeticAPOMultiPathPricer : public PathPricer<MultiPath> {
+      public:
+        ArithmeticAPOMultiPathPricer(Option::Type type,
+                                     Real strike,
+                                     DiscountFactor discount,
+                                     Real runningSum = 0.0,
+                                     Size pastFixings = 0)
+        : payoff_(type, strike), discount_(discount),
+          runningSum_(runningSum), pastFixings_(pastFixings) {
+            QL_REQUIRE(strike>=0.0,
+                       "strike less than zero not allowed");
+        }
+
+        Real operator()(const MultiPath& multiPath) const {
+            const Path& path = multiPath[0];
+            const Size n = path.length();
+            QL_REQUIRE(n>1, "the path cannot be empty");
+
+            Real sum;
+            Size fixings;
+            if (path.timeGrid().mandatoryTimes()[0]==0.0) {
+                // include initial fixing
+                sum = std::accumulate(path.begin(),path.end(),runningSum_);
+                fixings = pastFixings_ + n;
+            } else {
+                sum = std::accumulate(path.begin()+1,path.end(),runningSum_);
+                fixings = pastFixings_ + n - 1;
+            }
+            Real averagePrice = sum/fixings;
+            return discount_ * payoff_(averagePrice);
+        }
+      private:
+        PlainVanillaPayoff payoff_;
+        DiscountFactor discount_;
+        Real runningSum_;
+        Size pastFixings_;
+    };
+
+}
+
+
+#endif
@@ -0,0 +1,156 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "./perfcounters.hpp"
+#include <ql/utilities/null.hpp>
+#include <boost/cstdint.hpp>
+#include <cstring>
+#include <cerrno>
+#include <sys/time.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define QL_CONST_PERF_EVENTS
+#endif
+
+namespace QuantLib {
+
+    namespace {
+
+        double wallClock() {
+            timeval tv;
+            gettimeofday(&tv, 0);
+            return tv.tv_sec + 1.0e-6*tv.tv_usec;
+        }
+
+        #ifdef QL_CONST_PERF_EVENTS
+        const boost::uint64_t hardwareEvents[PerfSample::Events] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        int openCounter(boost::uint64_t config) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+            return int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+        #endif
+
+    }
+
+    PerfSample::PerfSample() : seconds(0.0) {
+        for (Size i=0; i<Events; ++i) {
+            count[i] = 0.0;
+            counted[i] = false;
+        }
+    }
+
+    Real PerfSample::ipc() const {
+        if (!counted[Cycles] || !counted[Instructions] || count[Cycles] == 0.0)
+            return Null<Real>();
+        return count[Instructions]/count[Cycles];
+    }
+
+    Real PerfSample::per(Event e, double units) const {
+        if (!counted[e] || units == 0.0)
+            return Null<Real>();
+        return count[e]/units;
+    }
+
+
+    PerfCounters::PerfCounters() : started_(0.0) {
+        for (Size i=0; i<PerfSample::Events; ++i)
+            fd_[i] = -1;
+        #ifdef QL_CONST_PERF_EVENTS
+        for (Size i=0; i<PerfSample::Events; ++i) {
+            fd_[i] = openCounter(hardwareEvents[i]);
+            if (fd_[i] < 0 && status_.empty())
+                status_ = std::string("perf_event_open: ")
+                        + std::strerror(errno);
+        }
+        if (available() && fd_[PerfSample::CacheMisses] >= 0 &&
+            fd_[PerfSample::BranchMisses] >= 0)
+            status_ = "all counters available";
+        else if (available())
+            status_ = "partial counters, " + status_;
+        #else
+        status_ = "hardware counters not supported on this platform";
+        #endif
+    }
+
+    PerfCounters::~PerfCounters() {
+        #ifdef QL_CONST_PERF_EVENTS
+        for (Size i=0; i<PerfSample::Events; ++i)
+            if (fd_[i] >= 0)
+                close(fd_[i]);
+        #endif
+    }
+
+    bool PerfCounters::available() const {
+        return available(PerfSample::Cycles) &&
+               available(PerfSample::Instructions);
+    }
+
+    bool PerfCounters::available(PerfSample::Event e) const {
+        return fd_[e] >= 0;
+    }
+
+    void PerfCounters::start() {
+        #ifdef QL_CONST_PERF_EVENTS
+        for (Size i=0; i<PerfSample::Events; ++i) {
+            if (fd_[i] >= 0) {
+                ioctl(fd_[i], PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd_[i], PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+        #endif
+        started_ = wallClock();
+    }
+
+    PerfSample PerfCounters::stop() {
+        PerfSample sample;
+        #ifdef QL_CONST_PERF_EVENTS
+        for (Size i=0; i<PerfSample::Events; ++i)
+            if (fd_[i] >= 0)
+                ioctl(fd_[i], PERF_EVENT_IOC_DISABLE, 0);
+        #endif
+        sample.seconds = wallClock() - started_;
+        #ifdef QL_CONST_PERF_EVENTS
+        for (Size i=0; i<PerfSample::Events; ++i) {
+            // value, time enabled, time running
+            boost::uint64_t data[3];
+            if (fd_[i] < 0 ||
+                read(fd_[i], data, sizeof(data)) != ssize_t(sizeof(data)))
+                continue;
+            if (data[2] == 0)
+                continue;   // never scheduled on the PMU
+            sample.count[i] = double(data[0]);
+            if (data[2] < data[1])
+                sample.count[i] *= double(data[1])/double(data[2]);
+            sample.counted[i] = true;
+        }
+        #endif
+        return sample;
+    }
+
+}
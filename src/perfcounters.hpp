@@ -0,0 +1,71 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file perfcounters.hpp
+    \brief hardware performance counters around benchmark phases
+*/
+
+#ifndef quantlib_perf_counters_hpp
+#define quantlib_perf_counters_hpp
+
+#include <ql/types.hpp>
+#include <boost/noncopyable.hpp>
+#include <string>
+
+namespace QuantLib {
+
+    //! counts of one measured phase
+    struct PerfSample {
+        enum Event { Cycles, Instructions, CacheMisses, BranchMisses,
+                     Events };
+
+        PerfSample();
+
+        double seconds;
+        double count[Events];
+        bool counted[Events];
+
+        //! instructions per cycle, Null<Real>() if not counted
+        Real ipc() const;
+        //! count per unit of work, Null<Real>() if not counted
+        Real per(Event e, double units) const;
+    };
+
+    //! user-space counters of the calling thread (Linux perf_event)
+    /*! Each event is opened on its own, so that a machine or a
+        virtual machine without, say, cache-miss events still counts
+        cycles. When perf_event_open is not there or not allowed (see
+        /proc/sys/kernel/perf_event_paranoid), nothing is counted,
+        status() says why, and start()/stop() only measure wall-clock
+        time. Counts are scaled when the kernel multiplexes them.
+    */
+    class PerfCounters : private boost::noncopyable {
+      public:
+        PerfCounters();
+        ~PerfCounters();
+
+        //! true if at least cycles and instructions are counted
+        bool available() const;
+        bool available(PerfSample::Event e) const;
+        const std::string& status() const { return status_; }
+
+        void start();
+        PerfSample stop();
+
+      private:
+        int fd_[PerfSample::Events];
+        std::string status_;
+        double started_;
+    };
+
+}
+
+
+#endif
@@ -0,0 +1,292 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2016 Yiqiao CHEN
+
+
+ This file is part of the QuantLib constant parameters project
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file shardedsimulation.hpp
+    \brief one Monte Carlo simulation split over several local processes
+*/
+
+#ifndef quantlib_sharded_simulation_hpp
+#define quantlib_sharded_simulation_hpp
+
+#include <ql/instrument.hpp>
+#include <ql/errors.hpp>
+#include <ql/types.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <vector>
+#include <cerrno>
+#include <math.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace QuantLib {
+
+    //! mergeable summary of one shard
+    /*! Fixed-width record, written as is on pipes; the same 24 bytes
+        can be shipped over any other transport. The engines in this
+        project compute no pathwise Greeks, so only the price moments
+        are carried. */
+    struct ShardAccumulator {
+        boost::uint64_t count;
+        double mean;
+        // sum of squared deviations from the mean
+        double m2;
+
+        ShardAccumulator() : count(0), mean(0.0), m2(0.0) {}
+
+        template <class S>
+        static ShardAccumulator from(const S& stats) {
+            ShardAccumulator a;
+            a.count = stats.samples();
+            if (a.count > 0) {
+                a.mean = stats.mean();
+                a.m2 = a.count > 1 ? stats.variance()*(a.count-1) : 0.0;
+            }
+            return a;
+        }
+
+        //! Chan et al. pairwise update
+        void merge(const ShardAccumulator& other) {
+            if (other.count == 0)
+                return;
+            if (count == 0) {
+                *this = other;
+                return;
+            }
+            Real n = Real(count) + Real(other.count);
+            Real delta = other.mean - mean;
+            mean += delta*Real(other.count)/n;
+            m2 += other.m2 + delta*delta*Real(count)*Real(other.count)/n;
+            count += other.count;
+        }
+
+        Real errorEstimate() const {
+            QL_REQUIRE(count > 1, "not enough samples");
+            return std::sqrt(m2/(count-1)/count);
+        }
+    };
+
+
+    //! one simulation split into shards run by forked workers
+    /*! The total number of samples is cut into a fixed number of
+        shards, and each worker gets a contiguous range of them. A
+        worker builds one engine with the given factory on the common
+        seed and starts it with setFirstSample() at the first path of
+        its range; the generator is positioned there once (directly for
+        Sobol, by drawing the earlier uniforms otherwise) and each later
+        shard of the range goes on where the previous one stopped. The
+        shards are thus disjoint, contiguous parts of the stream of one
+        ordinary engine run with the same seed and samples, and they are
+        merged in shard order whatever the number of workers. The
+        result is the one of that single run, up to the rounding of the
+        merge, and run(1) and run(n) are bit-identical.
+
+        E is the engine type, e.g. MCEuropeanConstEngine<PseudoRandom>
+        or MCDiscreteArithmeticAPConstEngine<PseudoRandom>, on constant
+        parameters; it needs setFirstSample(), setRequiredSamples() and
+        sampleAccumulator().
+        The instrument only provides the arguments; its own engine is
+        left alone.
+    */
+    template <class E>
+    class ShardedSimulation {
+      public:
+        typedef boost::function<boost::shared_ptr<E>(BigNatural, Size)>
+            engine_factory;
+
+        ShardedSimulation(Instrument& instrument,
+                          const engine_factory& factory,
+                          BigNatural seed,
+                          Size samples,
+                          Size shards)
+        : instrument_(instrument), factory_(factory), seed_(seed),
+          samples_(samples), shards_(shards) {
+            QL_REQUIRE(shards_ > 0, "at least one shard required");
+            QL_REQUIRE(samples_ >= shards_, "fewer samples than shards");
+        }
+
+        Size samples(Size i) const {
+            return samples_/shards_ + (i < samples_%shards_ ? 1 : 0);
+        }
+
+        //! index of the first path of shard i in the seed's stream
+        Size firstSample(Size i) const {
+            return i*(samples_/shards_) + std::min(i, samples_%shards_);
+        }
+
+        //! first shard of worker w out of the given number
+        Size firstShard(Size w, Size workers) const {
+            return w*(shards_/workers) + std::min(w, shards_%workers);
+        }
+
+        //! runs shard i in this process
+        ShardAccumulator runShard(Size i) const {
+            std::vector<ShardAccumulator> result(1);
+            runShards(i, i+1, result);
+            return result[0];
+        }
+
+        //! runs shards [begin, end) in this process, on one engine
+        void runShards(Size begin, Size end,
+                       std::vector<ShardAccumulator>& results) const {
+            boost::shared_ptr<E> engine = factory_(seed_, samples(begin));
+            for (Size i=begin; i<end; ++i) {
+                engine->setRequiredSamples(samples(i));
+                engine->setFirstSample(firstSample(i));
+                // as Instrument::performCalculations, without binding
+                // the engine to the caller's instrument
+                engine->reset();
+                instrument_.setupArguments(engine->getArguments());
+                engine->getArguments()->validate();
+                engine->calculate();
+                results[i-begin] =
+                    ShardAccumulator::from(engine->sampleAccumulator());
+            }
+        }
+
+        //! runs all shards on the given number of worker processes
+        /*! With one worker, or less, everything runs in this process. */
+        ShardAccumulator run(Size workers) const {
+            std::vector<ShardAccumulator> results(shards_);
+            if (workers <= 1) {
+                runShards(0, shards_, results);
+            } else {
+                runForked(std::min(workers, shards_), results);
+            }
+
+            ShardAccumulator total;
+            for (Size i=0; i<shards_; ++i)
+                total.merge(results[i]);
+            return total;
+        }
+
+      private:
+        struct Record {
+            boost::uint64_t shard;
+            ShardAccumulator accumulator;
+        };
+
+        static bool writeAll(int fd, const char* p, Size n) {
+            while (n > 0) {
+                ssize_t k = ::write(fd, p, n);
+                if (k < 0 && errno == EINTR)
+                    continue;
+                if (k <= 0)
+                    return false;
+                p += k;
+                n -= k;
+            }
+            return true;
+        }
+
+        static Size readAll(int fd, char* p, Size n) {
+            Size done = 0;
+            while (done < n) {
+                ssize_t k = ::read(fd, p+done, n-done);
+                if (k < 0 && errno == EINTR)
+                    continue;
+                if (k <= 0)
+                    break;
+                done += k;
+            }
+            return done;
+        }
+
+        void runForked(Size workers,
+                       std::vector<ShardAccumulator>& results) const {
+            std::vector<pid_t> pids(workers, -1);
+            std::vector<int> fds(workers, -1);
+            for (Size w=0; w<workers; ++w) {
+                int p[2];
+                QL_REQUIRE(::pipe(p) == 0, "cannot create pipe");
+                pid_t pid = ::fork();
+                if (pid == 0) {
+                    // worker: a contiguous range of shards
+                    ::close(p[0]);
+                    int status = 0;
+                    try {
+                        Size begin = firstShard(w, workers);
+                        Size end = firstShard(w+1, workers);
+                        std::vector<ShardAccumulator> range(end-begin);
+                        runShards(begin, end, range);
+                        for (Size i=begin; i<end; ++i) {
+                            Record r;
+                            r.shard = i;
+                            r.accumulator = range[i-begin];
+                            if (!writeAll(p[1],
+                                          reinterpret_cast<const char*>(&r),
+                                          sizeof(Record))) {
+                                status = 1;
+                                break;
+                            }
+                        }
+                    } catch (...) {
+                        status = 1;
+                    }
+                    ::close(p[1]);
+                    ::_exit(status);
+                }
+                ::close(p[1]);
+                if (pid < 0) {
+                    ::close(p[0]);
+                    reap(pids, fds);
+                    QL_FAIL("cannot fork worker " << w);
+                }
+                pids[w] = pid;
+                fds[w] = p[0];
+            }
+
+            std::vector<bool> received(shards_, false);
+            for (Size w=0; w<workers; ++w) {
+                Record r;
+                while (readAll(fds[w], reinterpret_cast<char*>(&r),
+                               sizeof(Record)) == sizeof(Record)) {
+                    if (r.shard < shards_) {
+                        results[r.shard] = r.accumulator;
+                        received[r.shard] = true;
+                    }
+                }
+            }
+            bool ok = reap(pids, fds);
+            QL_REQUIRE(ok, "a simulation worker failed");
+            for (Size i=0; i<shards_; ++i)
+                QL_REQUIRE(received[i], "shard " << i << " missing");
+        }
+
+        static bool reap(std::vector<pid_t>& pids, std::vector<int>& fds) {
+            bool ok = true;
+            for (Size w=0; w<pids.size(); ++w) {
+                if (fds[w] >= 0)
+                    ::close(fds[w]);
+                if (pids[w] > 0) {
+                    int status = 0;
+                    pid_t r;
+                    while ((r = ::waitpid(pids[w], &status, 0)) < 0
+                           && errno == EINTR) {}
+                    ok = ok && r == pids[w] && WIFEXITED(status)
+                            && WEXITSTATUS(status) == 0;
+                }
+            }
+            return ok;
+        }
+
+        Instrument& instrument_;
+        engine_factory factory_;
+        BigNatural seed_;
+        Size samples_, shards_;
+    };
+
+}
+
+
+#endif
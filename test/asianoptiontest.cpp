@@ -190,6 +190,54 @@ int main(int argc, char* argv[]){
         res = asianOption.NPV();     
         t2 = clock();
         std::cout << "MC const(Sobol) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // local volatility sampled once onto the time/log-spot grid,
+        // on a smile; the reference simulates the Dupire surface itself
+        std::vector<Date> smileDates(3);
+        smileDates[0] = Date(17, May, 1999);
+        smileDates[1] = Date(17, May, 2000);
+        smileDates[2] = Date(17, May, 2001);
+        std::vector<Real> smileStrikes(5);
+        Real smileVols[5] = { 0.27, 0.23, 0.20, 0.19, 0.20 };
+        Matrix smileMatrix(smileStrikes.size(), smileDates.size());
+        for (Size i=0; i<smileStrikes.size(); ++i) {
+            smileStrikes[i] = 24.0 + 6.0*i;
+            for (Size j=0; j<smileDates.size(); ++j)
+                smileMatrix[i][j] = smileVols[i] - 0.01*j;
+        }
+        boost::shared_ptr<BlackVarianceSurface> smileSurface(
+                new BlackVarianceSurface(todaysDate, calendar, smileDates,
+                                         smileStrikes, smileMatrix, dayCounter,
+                                         BlackVarianceSurface::ConstantExtrapolation,
+                                         BlackVarianceSurface::ConstantExtrapolation));
+        smileSurface->enableExtrapolation();
+        boost::shared_ptr<BlackScholesMertonProcess> smileProcess(
+                new BlackScholesMertonProcess(underlyingH, flatDividendTS, flatTermStructure,
+                                              Handle<BlackVolTermStructure>(smileSurface)));
+
+        boost::shared_ptr<PricingEngine> mcengine3;
+        mcengine3 = MakeMCDiscreteArithmeticAPEngine <PseudoRandom>(smileProcess)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        asianOption.setPricingEngine(mcengine3);
+
+        t1 = clock();
+        res = asianOption.NPV();
+        t2 = clock();
+        std::cout << "MC (local vol, smile) : " << res << " +/- " << asianOption.errorEstimate() << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        boost::shared_ptr<PricingEngine> mcengine3c;
+        mcengine3c = MakeMCDiscreteArithmeticAPConstEngine <PseudoRandom>(smileProcess, true)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed)
+            .withLocalVolGrid();
+        asianOption.setPricingEngine(mcengine3c);
+
+        t1 = clock();
+        res = asianOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(local vol grid, smile) : " << res << " +/- " << asianOption.errorEstimate() << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
         
 
         // End test
@@ -0,0 +1,209 @@
+#include <ql/quantlib.hpp>
+#include <boost/timer.hpp>
+#include <iomanip>
+#include "../src/blackscholesconstprocess.hpp"
+#include "../src/mceuropeanconstengine.hpp"
+#include "../src/mc_discr_arith_av_price_const.hpp"
+#include "../src/asyncpricer.hpp"
+
+using namespace QuantLib;
+using namespace boost::posix_time;
+
+typedef MCEuropeanConstEngine<PseudoRandom> EuropeanEngine;
+typedef MCDiscreteArithmeticAPConstEngine<PseudoRandom> AsianEngine;
+
+const char* statusName(AsyncPricingResult::Status s) {
+    switch (s) {
+      case AsyncPricingResult::Running:           return "running";
+      case AsyncPricingResult::Converged:         return "converged";
+      case AsyncPricingResult::MaxSamplesReached: return "max samples reached";
+      case AsyncPricingResult::DeadlineReached:   return "deadline reached";
+      case AsyncPricingResult::Cancelled:         return "cancelled";
+      default:                                    return "failed";
+    }
+}
+
+void print(const std::string& name, const AsyncPricingResult& r,
+           const ptime& started) {
+    std::cout << name << " : " << r.value << " +/- " << r.errorEstimate
+              << " with " << r.samples << " samples, "
+              << statusName(r.status)
+              << (r.message.empty() ? "" : " (" + r.message + ")")
+              << " (" << (microsec_clock::universal_time()-started).total_milliseconds()
+              << "ms)" << std::endl;
+}
+
+// polls the running estimate until the future is ready
+AsyncPricingResult watch(const boost::shared_future<AsyncPricingResult>& future,
+                         const boost::shared_ptr<PricingMonitor>& monitor,
+                         const ptime& started,
+                         Size cancelAfterMs = Null<Size>()) {
+    while (!future.is_ready()) {
+        boost::this_thread::sleep(milliseconds(5));
+        if (cancelAfterMs != Null<Size>() &&
+            (microsec_clock::universal_time()-started).total_milliseconds()
+                >= long(cancelAfterMs))
+            monitor->cancel();
+        AsyncPricingResult r = monitor->current();
+        if (r.samples > 0)
+            print("  running", r, started);
+    }
+    return future.get();
+}
+
+int main(int argc, char* argv[]){
+    
+    try{
+        
+        boost::timer timer;
+        std::cout << std::endl;
+
+        // set up dates
+        Calendar calendar = TARGET();
+        Date todaysDate(15, May, 1998);
+        Date settlementDate(17, May, 1998);
+        Settings::instance().evaluationDate() = todaysDate;
+
+        // our option parameters
+        Option::Type type(Option::Put);
+        Real underlying = 36;
+        Real strike = 40;
+        Spread dividendYield = 0.00;
+        Rate riskFreeRate = 0.06;
+        Volatility volatility = 0.20;
+
+        Date maturity(17, May, 2001);
+
+        DayCounter dayCounter = Actual365Fixed();
+
+        std::cout << "Option type = "  << type << std::endl;
+        std::cout << "Maturity = "        << maturity << std::endl;
+        std::cout << "Underlying price = "        << underlying << std::endl;
+        std::cout << "Strike = "                  << strike << std::endl;
+        std::cout << std::endl;
+
+
+        // underlying handler
+        Handle<Quote> underlyingH(
+                boost::shared_ptr<Quote>(new SimpleQuote(underlying)));
+
+        // bootstrap the yield/dividend/vol curves
+        Handle<YieldTermStructure> flatTermStructure(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, riskFreeRate, dayCounter)));
+        Handle<YieldTermStructure> flatDividendTS(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, dividendYield, dayCounter)));
+        Handle<BlackVolTermStructure> flatVolTS(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackConstantVol(settlementDate, calendar, volatility,
+                                     dayCounter)));
+
+        boost::shared_ptr<BlackScholesMertonProcess> bsmProcess(
+                new BlackScholesMertonProcess(underlyingH, flatDividendTS, flatTermStructure, flatVolTS));
+
+        // options
+        boost::shared_ptr<Exercise> europeanExercise(
+                new EuropeanExercise(maturity));
+        boost::shared_ptr<StrikedTypePayoff> payoff(
+                new PlainVanillaPayoff(type, strike));
+        boost::shared_ptr<VanillaOption> europeanOption(
+                new VanillaOption(payoff, europeanExercise));
+
+        std::vector<Date> fixingDates;
+        for (Integer i=1; i<=36; ++i)
+            fixingDates.push_back(todaysDate + i*Months);
+        boost::shared_ptr<DiscreteAveragingAsianOption> asianOption(
+                new DiscreteAveragingAsianOption(Average::Arithmetic, 0.0, 0,
+                                                 fixingDates, payoff,
+                                                 boost::shared_ptr<Exercise>(
+                                                     new EuropeanExercise(fixingDates.back()))));
+
+        BigNatural mcSeed = 42;
+        Size timeSteps = 12;
+        Size maxSamples = 1 << 24;
+        ptime started;
+        AsyncPricingResult res;
+
+        // 20ms deadline on far more samples than fit
+        {
+            boost::shared_ptr<EuropeanEngine> engine(
+                new EuropeanEngine(bsmProcess, timeSteps, Null<Size>(),
+                                   false, false, 1024, Null<Real>(),
+                                   Null<Size>(), mcSeed, true));
+            DeadlinePricer<EuropeanEngine> pricer(europeanOption, engine,
+                                                  maxSamples);
+            boost::shared_ptr<PricingMonitor> monitor(new PricingMonitor);
+            started = microsec_clock::universal_time();
+            res = watch(pricer.async(monitor, started + milliseconds(20)),
+                        monitor, started);
+            print("MC const(European, 20ms deadline)", res, started);
+        }
+
+        // tolerance, no deadline
+        {
+            boost::shared_ptr<EuropeanEngine> engine(
+                new EuropeanEngine(bsmProcess, timeSteps, Null<Size>(),
+                                   false, false, 1024, Null<Real>(),
+                                   Null<Size>(), mcSeed, true));
+            DeadlinePricer<EuropeanEngine> pricer(europeanOption, engine,
+                                                  maxSamples, 0.01);
+            boost::shared_ptr<PricingMonitor> monitor(new PricingMonitor);
+            started = microsec_clock::universal_time();
+            res = watch(pricer.async(monitor), monitor, started);
+            print("MC const(European, tol 0.01)", res, started);
+        }
+
+        // cancelled by the caller after 10ms
+        {
+            boost::shared_ptr<EuropeanEngine> engine(
+                new EuropeanEngine(bsmProcess, timeSteps, Null<Size>(),
+                                   false, false, 1024, Null<Real>(),
+                                   Null<Size>(), mcSeed, true));
+            DeadlinePricer<EuropeanEngine> pricer(europeanOption, engine,
+                                                  maxSamples);
+            boost::shared_ptr<PricingMonitor> monitor(new PricingMonitor);
+            started = microsec_clock::universal_time();
+            res = watch(pricer.async(monitor), monitor, started, 10);
+            print("MC const(European, cancelled)", res, started);
+        }
+
+        // Asian with a 50ms deadline
+        {
+            boost::shared_ptr<AsianEngine> engine(
+                new AsianEngine(bsmProcess, false, false, false,
+                                1024, Null<Real>(), Null<Size>(),
+                                mcSeed, true));
+            DeadlinePricer<AsianEngine> pricer(asianOption, engine,
+                                               maxSamples);
+            boost::shared_ptr<PricingMonitor> monitor(new PricingMonitor);
+            started = microsec_clock::universal_time();
+            res = watch(pricer.async(monitor, started + milliseconds(50)),
+                        monitor, started);
+            print("MC const(Asian, 50ms deadline)", res, started);
+        }
+
+
+        // End test
+        double seconds = timer.elapsed();
+        Integer hours = int(seconds/3600);
+        seconds -= hours * 3600;
+        Integer minutes = int(seconds/60);
+        seconds -= minutes * 60;
+        std::cout << " \nRun completed in ";
+        if (hours > 0)
+            std::cout << hours << " h ";
+        if (hours > 0 || minutes > 0)
+            std::cout << minutes << " m ";
+        std::cout << std::fixed << std::setprecision(0)
+                  << seconds << " s\n" << std::endl;
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+        return 1;
+    }
+}
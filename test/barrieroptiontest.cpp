@@ -0,0 +1,219 @@
+#include <ql/quantlib.hpp>
+#include <boost/timer.hpp>
+#include <iomanip>
+#include "../src/blackscholesconstprocess.hpp"
+#include "../src/mcbarrierconstengine.hpp"
+
+using namespace QuantLib;
+
+int main(int argc, char* argv[]){
+    
+    try{
+        
+        boost::timer timer;
+        std::cout << std::endl;
+
+        // set up dates
+        Calendar calendar = TARGET();
+        Date todaysDate(15, May, 1998);
+        Date settlementDate(17, May, 1998);
+        Settings::instance().evaluationDate() = todaysDate;
+
+        // our option parameters
+        Option::Type type(Option::Put);
+        Real underlying = 36;
+        Real strike = 40;
+        Spread dividendYield = 0.00;
+        Rate riskFreeRate = 0.06;
+        Volatility volatility = 0.20;
+        Barrier::Type barrierType(Barrier::DownOut);
+        Real barrier = 30;
+        Real rebate = 0.0;
+
+        Date maturity(17, May, 2001);
+
+        DayCounter dayCounter = Actual365Fixed();
+
+        std::cout << "Option type = "  << type << std::endl;
+        std::cout << "Maturity = "        << maturity << std::endl;
+        std::cout << "Underlying price = "        << underlying << std::endl;
+        std::cout << "Strike = "                  << strike << std::endl;
+        std::cout << "Barrier = "                 << barrierType << " "
+                  << barrier << std::endl;
+        std::cout << "Risk-free interest rate = " << io::rate(riskFreeRate)
+                  << std::endl;
+        std::cout << "Dividend yield = " << io::rate(dividendYield)
+                  << std::endl;
+        std::cout << "Volatility = " << io::volatility(volatility)
+                  << std::endl;
+        std::cout << std::endl;
+        std::string method;
+        std::cout << std::endl ;
+
+
+        // underlying handler
+        Handle<Quote> underlyingH(
+                boost::shared_ptr<Quote>(new SimpleQuote(underlying)));
+
+        // bootstrap the yield/dividend/vol curves
+        Handle<YieldTermStructure> flatTermStructure(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, riskFreeRate, dayCounter)));
+        Handle<YieldTermStructure> flatDividendTS(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, dividendYield, dayCounter)));
+        Handle<BlackVolTermStructure> flatVolTS(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackConstantVol(settlementDate, calendar, volatility,
+                                     dayCounter)));
+ 
+ 
+        // bootstrap the yield/dividend/vol forward curves   
+        
+        std::vector<Date> dates1(3);
+        std::vector<Rate> rates(3);
+
+        dates1[0] = Date(17, May, 1998);    
+        dates1[1] = Date(17, May, 1999); //todaysDate+1*Years;    
+        dates1[2] = Date(17, May, 2001); //todaysDate+3*Years; 
+        
+        rates[0] = 0.06;
+        rates[1] = 0.05;
+        rates[2] = 0.04;
+        
+        
+        Handle<YieldTermStructure> fowardTermStructure(
+            boost::shared_ptr<YieldTermStructure>(
+                new ForwardCurve(dates1, rates, dayCounter)));
+                
+        Handle<YieldTermStructure> fowardDividendTS(
+            boost::shared_ptr<YieldTermStructure>(
+                new ForwardCurve(dates1, rates, dayCounter)));
+                
+        std::vector<Volatility> vols(2);
+        std::vector<Date> dates2(2);
+        
+        dates2[0] = Date(17, May, 1999); //todaysDate+1*Years;    
+        dates2[1] = Date(17, May, 2001); //todaysDate+3*Years; 
+        
+        vols[0] = 0.20;
+        vols[1] = 0.25;
+        
+        Handle<BlackVolTermStructure> fowardVolTS(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackVarianceCurve(todaysDate, dates2, vols,
+                                     dayCounter)));
+        
+        // european exercise
+        boost::shared_ptr<Exercise> europeanExercise(
+                new EuropeanExercise(maturity));
+
+        // payoff
+        boost::shared_ptr<StrikedTypePayoff> payoff(
+                new PlainVanillaPayoff(type, strike));
+        // options
+        BarrierOption barrierOption(barrierType, barrier, rebate,
+                                    payoff, europeanExercise);
+
+
+        // BlackScholes Merton Process platForward
+        boost::shared_ptr<BlackScholesMertonProcess> flatbsmProcess(
+                new BlackScholesMertonProcess(underlyingH, flatDividendTS, flatTermStructure, flatVolTS));
+
+        // BlackScholes Merton Process forward curve
+        boost::shared_ptr<BlackScholesMertonProcess> bsmProcess(
+                new BlackScholesMertonProcess(underlyingH, fowardDividendTS, fowardTermStructure, fowardVolTS));
+
+        // Analytic barrier (continuous monitoring) plat
+
+        barrierOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                    new AnalyticBarrierEngine(flatbsmProcess)));
+        clock_t t1,t2;
+        Real res;
+
+        t1 = clock();
+        res = barrierOption.NPV();
+        t2 = clock();
+        std::cout << "Analytic barrier(flat curve) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // Monte Carlo Method: MC (crude) on a fine grid
+
+        Size mcSeed = 42;
+
+        boost::shared_ptr<PricingEngine> mcengine1;
+        mcengine1 = MakeMCBarrierConstEngine<PseudoRandom>(flatbsmProcess, false)
+            .withStepsPerYear(250)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        barrierOption.setPricingEngine(mcengine1);
+
+        t1 = clock();
+        res = barrierOption.NPV();
+        t2 = clock();
+        std::cout << "MC (crude, 250 steps/year) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // the const engine gets away with a much coarser grid
+        boost::shared_ptr<PricingEngine> mcengine1c;
+        mcengine1c = MakeMCBarrierConstEngine<PseudoRandom>(flatbsmProcess, true)
+            .withStepsPerYear(12)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        barrierOption.setPricingEngine(mcengine1c);
+
+        t1 = clock();
+        res = barrierOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(crude, 12 steps/year) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // forward curves
+        barrierOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+            MakeMCBarrierConstEngine<PseudoRandom>(bsmProcess, false)
+                .withStepsPerYear(250)
+                .withAbsoluteTolerance(0.02)
+                .withSeed(mcSeed)));
+
+        t1 = clock();
+        res = barrierOption.NPV();
+        t2 = clock();
+        std::cout << "MC (forward curve, 250 steps/year) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        barrierOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+            MakeMCBarrierConstEngine<PseudoRandom>(bsmProcess, true)
+                .withStepsPerYear(12)
+                .withAbsoluteTolerance(0.02)
+                .withSeed(mcSeed)));
+
+        t1 = clock();
+        res = barrierOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(forward curve, 12 steps/year) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // End test
+        double seconds = timer.elapsed();
+        Integer hours = int(seconds/3600);
+        seconds -= hours * 3600;
+        Integer minutes = int(seconds/60);
+        seconds -= minutes * 60;
+        std::cout << " \nRun completed in ";
+        if (hours > 0)
+            std::cout << hours << " h ";
+        if (hours > 0 || minutes > 0)
+            std::cout << minutes << " m ";
+        std::cout << std::fixed << std::setprecision(0)
+                  << seconds << " s\n" << std::endl;
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+        return 1;
+    }
+
+}
+
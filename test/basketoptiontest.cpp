@@ -0,0 +1,197 @@
+#include <ql/quantlib.hpp>
+#include <boost/timer.hpp>
+#include <iomanip>
+#include "../src/blackscholesconstmultiprocess.hpp"
+#include "../src/mceuropeanbasketconstengine.hpp"
+
+using namespace QuantLib;
+
+int main(int argc, char* argv[]){
+
+    try{
+
+        boost::timer timer;
+        std::cout << std::endl;
+
+        // set up dates
+        Calendar calendar = TARGET();
+        Date todaysDate(15, May, 1998);
+        Date settlementDate(17, May, 1998);
+        Settings::instance().evaluationDate() = todaysDate;
+
+        // our option parameters
+        Option::Type type(Option::Call);
+        Real underlying1 = 36;
+        Real underlying2 = 38;
+        Real strike = 40;
+        Spread dividendYield1 = 0.00;
+        Spread dividendYield2 = 0.02;
+        Rate riskFreeRate = 0.06;
+        Volatility volatility1 = 0.20;
+        Volatility volatility2 = 0.30;
+        Real correlation = 0.5;
+
+        Date maturity(17, May, 2001);
+
+        DayCounter dayCounter = Actual365Fixed();
+
+        std::cout << "Option type = "  << type << std::endl;
+        std::cout << "Maturity = "        << maturity << std::endl;
+        std::cout << "Underlying prices = "       << underlying1 << ", "
+                  << underlying2 << std::endl;
+        std::cout << "Strike = "                  << strike << std::endl;
+        std::cout << "Risk-free interest rate = " << io::rate(riskFreeRate)
+                  << std::endl;
+        std::cout << "Dividend yields = " << io::rate(dividendYield1) << ", "
+                  << io::rate(dividendYield2) << std::endl;
+        std::cout << "Volatilities = " << io::volatility(volatility1) << ", "
+                  << io::volatility(volatility2) << std::endl;
+        std::cout << "Correlation = " << correlation << std::endl;
+        std::cout << std::endl;
+
+
+        // underlying handlers
+        Handle<Quote> underlyingH1(
+                boost::shared_ptr<Quote>(new SimpleQuote(underlying1)));
+        Handle<Quote> underlyingH2(
+                boost::shared_ptr<Quote>(new SimpleQuote(underlying2)));
+
+        // bootstrap the yield/dividend/vol curves
+        Handle<YieldTermStructure> flatTermStructure(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, riskFreeRate, dayCounter)));
+        Handle<YieldTermStructure> flatDividendTS1(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, dividendYield1, dayCounter)));
+        Handle<YieldTermStructure> flatDividendTS2(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, dividendYield2, dayCounter)));
+        Handle<BlackVolTermStructure> flatVolTS1(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackConstantVol(settlementDate, calendar, volatility1,
+                                     dayCounter)));
+        Handle<BlackVolTermStructure> flatVolTS2(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackConstantVol(settlementDate, calendar, volatility2,
+                                     dayCounter)));
+
+        // european exercise
+        boost::shared_ptr<Exercise> europeanExercise(
+                new EuropeanExercise(maturity));
+
+        // payoffs
+        boost::shared_ptr<PlainVanillaPayoff> payoff(
+                new PlainVanillaPayoff(type, strike));
+        boost::shared_ptr<PlainVanillaPayoff> spreadPayoff(
+                new PlainVanillaPayoff(type, 0.0));
+
+        // options
+        BasketOption maxBasketOption(
+                boost::shared_ptr<BasketPayoff>(new MaxBasketPayoff(payoff)),
+                europeanExercise);
+        BasketOption spreadOption(
+                boost::shared_ptr<BasketPayoff>(
+                                      new SpreadBasketPayoff(spreadPayoff)),
+                europeanExercise);
+
+        // BlackScholes Merton Processes
+        boost::shared_ptr<BlackScholesMertonProcess> bsmProcess1(
+                new BlackScholesMertonProcess(underlyingH1, flatDividendTS1,
+                                              flatTermStructure, flatVolTS1));
+        boost::shared_ptr<BlackScholesMertonProcess> bsmProcess2(
+                new BlackScholesMertonProcess(underlyingH2, flatDividendTS2,
+                                              flatTermStructure, flatVolTS2));
+
+        std::vector<boost::shared_ptr<StochasticProcess1D> > procs;
+        procs.push_back(bsmProcess1);
+        procs.push_back(bsmProcess2);
+
+        Matrix correlationMatrix(2, 2, correlation);
+        correlationMatrix[0][0] = correlationMatrix[1][1] = 1.0;
+
+        boost::shared_ptr<StochasticProcessArray> processes(
+                new StochasticProcessArray(procs, correlationMatrix));
+
+        // Stulz for the max basket
+        maxBasketOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                    new StulzEngine(bsmProcess1, bsmProcess2, correlation)));
+        clock_t t1,t2;
+        Real res;
+
+        t1 = clock();
+        res = maxBasketOption.NPV();
+        t2 = clock();
+        std::cout << "Stulz (max basket) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // Monte Carlo Method: MC (crude)
+
+        Size timeSteps = 12;
+        Size mcSeed = 42;
+
+        boost::shared_ptr<PricingEngine> mcengine1;
+        mcengine1 = MakeMCEuropeanBasketConstEngine<PseudoRandom>(processes, false)
+            .withSteps(timeSteps)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        maxBasketOption.setPricingEngine(mcengine1);
+
+        t1 = clock();
+        res = maxBasketOption.NPV();
+        t2 = clock();
+        std::cout << "MC (max basket) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        boost::shared_ptr<PricingEngine> mcengine1c;
+        mcengine1c = MakeMCEuropeanBasketConstEngine<PseudoRandom>(processes, true)
+            .withSteps(timeSteps)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        maxBasketOption.setPricingEngine(mcengine1c);
+
+        t1 = clock();
+        res = maxBasketOption.NPV();
+        t2 = clock();
+        std::cout << "MC const (max basket) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // Spread option, same engines
+        spreadOption.setPricingEngine(mcengine1);
+
+        t1 = clock();
+        res = spreadOption.NPV();
+        t2 = clock();
+        std::cout << "MC (spread) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        spreadOption.setPricingEngine(mcengine1c);
+
+        t1 = clock();
+        res = spreadOption.NPV();
+        t2 = clock();
+        std::cout << "MC const (spread) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // End test
+        double seconds = timer.elapsed();
+        Integer hours = int(seconds/3600);
+        seconds -= hours * 3600;
+        Integer minutes = int(seconds/60);
+        seconds -= minutes * 60;
+        std::cout << " \nRun completed in ";
+        if (hours > 0)
+            std::cout << hours << " h ";
+        if (hours > 0 || minutes > 0)
+            std::cout << minutes << " m ";
+        std::cout << std::fixed << std::setprecision(0)
+                  << seconds << " s\n" << std::endl;
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+        return 1;
+    }
+
+}
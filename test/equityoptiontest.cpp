@@ -199,6 +199,244 @@ int main(int argc, char* argv[]){
         std::cout << "MC const(Sobol) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
         
 
+        // local volatility sampled once onto the time/log-spot grid
+        Size localVolSteps = 36;
+
+        boost::shared_ptr<PricingEngine> mcengine2lv;
+        mcengine2lv = MakeMCEuropeanEngine<PseudoRandom>(bsmProcess)
+            .withSteps(localVolSteps)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        europeanOption.setPricingEngine(mcengine2lv);
+
+        t1 = clock();
+        res = europeanOption.NPV();
+        t2 = clock();
+        std::cout << "MC (local vol) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        boost::shared_ptr<PricingEngine> mcengine2lvc;
+        mcengine2lvc = MakeMCEuropeanConstEngine<PseudoRandom>(bsmProcess, true)
+            .withSteps(localVolSteps)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed)
+            .withLocalVolGrid();
+        europeanOption.setPricingEngine(mcengine2lvc);
+
+        t1 = clock();
+        res = europeanOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(local vol grid) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        // smile: local vol is not a function of time only
+        std::vector<Date> smileDates(3);
+        smileDates[0] = Date(17, May, 1999);
+        smileDates[1] = Date(17, May, 2000);
+        smileDates[2] = Date(17, May, 2001);
+        std::vector<Real> smileStrikes(5);
+        Real smileVols[5] = { 0.27, 0.23, 0.20, 0.19, 0.20 };
+        Matrix smileMatrix(smileStrikes.size(), smileDates.size());
+        for (Size i=0; i<smileStrikes.size(); ++i) {
+            smileStrikes[i] = 24.0 + 6.0*i;
+            for (Size j=0; j<smileDates.size(); ++j)
+                smileMatrix[i][j] = smileVols[i] - 0.01*j;
+        }
+        boost::shared_ptr<BlackVarianceSurface> smileSurface(
+                new BlackVarianceSurface(todaysDate, calendar, smileDates,
+                                         smileStrikes, smileMatrix, dayCounter,
+                                         BlackVarianceSurface::ConstantExtrapolation,
+                                         BlackVarianceSurface::ConstantExtrapolation));
+        smileSurface->enableExtrapolation();
+        boost::shared_ptr<BlackScholesMertonProcess> smileProcess(
+                new BlackScholesMertonProcess(underlyingH, flatDividendTS, flatTermStructure,
+                                              Handle<BlackVolTermStructure>(smileSurface)));
+
+        europeanOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                    new AnalyticEuropeanEngine(smileProcess)));
+        t1 = clock();
+        res = europeanOption.NPV();
+        t2 = clock();
+        std::cout << "Black-Scholes(smile) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        boost::shared_ptr<PricingEngine> mcengine2lvs;
+        mcengine2lvs = MakeMCEuropeanConstEngine<PseudoRandom>(smileProcess, true)
+            .withSteps(localVolSteps)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed)
+            .withLocalVolGrid();
+        europeanOption.setPricingEngine(mcengine2lvs);
+
+        t1 = clock();
+        res = europeanOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(local vol grid, smile) : " << res << " +/- " << europeanOption.errorEstimate() << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // Deep out-of-the-money put: importance sampling
+        Real otmStrike = 20;
+        VanillaOption otmOption(
+                boost::shared_ptr<StrikedTypePayoff>(
+                                    new PlainVanillaPayoff(type, otmStrike)),
+                europeanExercise);
+        Size otmSamples = 16384;
+
+        otmOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                    new AnalyticEuropeanEngine(bsmProcess)));
+        res = otmOption.NPV();
+        std::cout << "Black-Scholes(forward curve, K=" << otmStrike << ") : " << res << std::endl;
+
+        boost::shared_ptr<PricingEngine> mcengine3c;
+        mcengine3c = MakeMCEuropeanConstEngine<PseudoRandom>(bsmProcess, true)
+            .withSteps(timeSteps)
+            .withSamples(otmSamples)
+            .withSeed(mcSeed);
+        otmOption.setPricingEngine(mcengine3c);
+
+        t1 = clock();
+        res = otmOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(crude, K=" << otmStrike << ") : " << res << " +/- " << otmOption.errorEstimate() << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        boost::shared_ptr<PricingEngine> mcengine3is;
+        mcengine3is = MakeMCEuropeanConstEngine<PseudoRandom>(bsmProcess, true)
+            .withSteps(timeSteps)
+            .withSamples(otmSamples)
+            .withSeed(mcSeed)
+            .withImportanceSampling();
+        otmOption.setPricingEngine(mcengine3is);
+
+        t1 = clock();
+        res = otmOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(importance sampling, K=" << otmStrike << ") : " << res << " +/- " << otmOption.errorEstimate() << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // repeated pricing of an unchanged trade: result cache
+        boost::shared_ptr<ConstResultCache> cache(new ConstResultCache(16));
+        boost::shared_ptr<PricingEngine> mcengine4c;
+        mcengine4c = MakeMCEuropeanConstEngine<PseudoRandom>(bsmProcess, true)
+            .withSteps(timeSteps)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed)
+            .withResultCache(cache);
+        europeanOption.setPricingEngine(mcengine4c);
+
+        for (Size i=0; i<3; ++i) {
+            t1 = clock();
+            // force the engine to run although nothing changed
+            europeanOption.recalculate();
+            res = europeanOption.NPV();
+            t2 = clock();
+            std::cout << "MC const(cached, run " << i+1 << ") : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+        }
+        std::cout << "cache hits/misses : " << cache->hits() << "/" << cache->misses() << std::endl;
+
+
+        // tighter request on the same engine: top-up of the samples
+        boost::shared_ptr<MCEuropeanConstEngine<PseudoRandom> > mcengine5c(
+            new MCEuropeanConstEngine<PseudoRandom>(
+                bsmProcess, timeSteps, Null<Size>(), false, false,
+                8192, Null<Real>(), Null<Size>(), mcSeed, true));
+        europeanOption.setPricingEngine(mcengine5c);
+
+        t1 = clock();
+        res = europeanOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(8192 samples) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        mcengine5c->setRequiredSamples(32768);
+        t1 = clock();
+        res = europeanOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(top-up to 32768) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        boost::shared_ptr<PricingEngine> mcengine5f;
+        mcengine5f = MakeMCEuropeanConstEngine<PseudoRandom>(bsmProcess, true)
+            .withSteps(timeSteps)
+            .withSamples(32768)
+            .withSeed(mcSeed);
+        europeanOption.setPricingEngine(mcengine5f);
+        t1 = clock();
+        Real fresh = europeanOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(32768 samples) : " << fresh << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+        std::cout << "identical : " << (res == fresh ? "yes" : "no") << std::endl;
+
+
+        // quoting on a moving spot: the engine keeps its path generator
+        boost::shared_ptr<SimpleQuote> spotQuote =
+            boost::dynamic_pointer_cast<SimpleQuote>(underlyingH.currentLink());
+        boost::shared_ptr<PricingEngine> mcengine6c;
+        mcengine6c = MakeMCEuropeanConstEngine<LowDiscrepancy>(bsmProcess, true)
+            .withSteps(timeSteps)
+            .withBrownianBridge()
+            .withSamples(1024);
+        europeanOption.setPricingEngine(mcengine6c);
+
+        for (Size i=0; i<5; ++i) {
+            spotQuote->setValue(underlying + 0.5*i);
+            t1 = clock();
+            res = europeanOption.NPV();
+            t2 = clock();
+            std::cout << "MC const(warm, S0=" << underlying + 0.5*i << ") : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+        }
+
+        boost::shared_ptr<PricingEngine> mcengine6f;
+        mcengine6f = MakeMCEuropeanConstEngine<LowDiscrepancy>(bsmProcess, true)
+            .withSteps(timeSteps)
+            .withBrownianBridge()
+            .withSamples(1024);
+        europeanOption.setPricingEngine(mcengine6f);
+        t1 = clock();
+        fresh = europeanOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(cold, S0=" << underlying + 2.0 << ") : " << fresh << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+        std::cout << "identical : " << (res == fresh ? "yes" : "no") << std::endl;
+        spotQuote->setValue(underlying);
+
+
+        // same tolerance: antithetic only, then stratified/moment-matched
+        Real tolerance = 0.002;
+        boost::shared_ptr<PricingEngine> mcengine7a;
+        mcengine7a = MakeMCEuropeanConstEngine<PseudoRandom>(bsmProcess, true)
+            .withSteps(1)
+            .withAntitheticVariate()
+            .withAbsoluteTolerance(tolerance)
+            .withSeed(mcSeed);
+        europeanOption.setPricingEngine(mcengine7a);
+        t1 = clock();
+        res = europeanOption.NPV();
+        t2 = clock();
+        // each antithetic sample evaluates two payoffs
+        Size baselinePayoffs = 2 *
+            boost::dynamic_pointer_cast<MCEuropeanConstEngine<PseudoRandom> >(
+                mcengine7a)->sampleAccumulator().samples();
+        std::cout << "MC const(antithetic, tol " << tolerance << ") : " << res << " +/- " << europeanOption.errorEstimate()
+                  << " with " << baselinePayoffs << " payoffs"
+                  << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        Size strata[] = { 64, 1, 64 };
+        bool matched[] = { false, true, true };
+        for (Size i=0; i<3; ++i) {
+            boost::shared_ptr<PricingEngine> mcengine7s;
+            mcengine7s = MakeMCEuropeanConstEngine<PseudoRandom>(bsmProcess, true)
+                .withSteps(1)
+                .withAntitheticVariate()
+                .withStratification(strata[i])
+                .withMomentMatching(matched[i])
+                .withAbsoluteTolerance(tolerance)
+                .withSeed(mcSeed);
+            europeanOption.setPricingEngine(mcengine7s);
+            t1 = clock();
+            res = europeanOption.NPV();
+            t2 = clock();
+            std::cout << "MC const(" << strata[i] << " strata"
+                      << (matched[i] ? ", moment matched" : "")
+                      << ", tol " << tolerance << ") : " << res << " +/- " << europeanOption.errorEstimate()
+                      << " with " << europeanOption.result<Real>("samples") << " payoffs"
+                      << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+        }
+
+
         // End test
         double seconds = timer.elapsed();
         Integer hours = int(seconds/3600);
@@ -0,0 +1,180 @@
+#include <ql/quantlib.hpp>
+#include <boost/timer.hpp>
+#include <iomanip>
+#include "../src/hestonconstprocess.hpp"
+#include "../src/mchestonconstengine.hpp"
+
+using namespace QuantLib;
+
+int main(int argc, char* argv[]){
+    
+    try{
+        
+        boost::timer timer;
+        std::cout << std::endl;
+
+        // set up dates
+        Date todaysDate(15, May, 1998);
+        Settings::instance().evaluationDate() = todaysDate;
+
+        // our option parameters
+        Option::Type type(Option::Put);
+        Real underlying = 36;
+        Real strike = 40;
+
+        // Heston parameters
+        Real v0 = 0.04;
+        Real kappa = 1.5;
+        Real theta = 0.0625;
+        Real sigma = 0.5;
+        Real rho = -0.7;
+
+        Date maturity(17, May, 2001);
+
+        DayCounter dayCounter = Actual365Fixed();
+
+        std::cout << "Option type = "  << type << std::endl;
+        std::cout << "Maturity = "        << maturity << std::endl;
+        std::cout << "Underlying price = "        << underlying << std::endl;
+        std::cout << "Strike = "                  << strike << std::endl;
+        std::cout << "v0 = " << v0 << ", kappa = " << kappa
+                  << ", theta = " << theta << ", sigma = " << sigma
+                  << ", rho = " << rho << std::endl;
+        std::cout << std::endl;
+
+
+        // underlying handler
+        Handle<Quote> underlyingH(
+                boost::shared_ptr<Quote>(new SimpleQuote(underlying)));
+
+        // bootstrap the yield/dividend forward curves
+        std::vector<Date> dates1(3);
+        std::vector<Rate> rates(3);
+
+        dates1[0] = Date(17, May, 1998);    
+        dates1[1] = Date(17, May, 1999); //todaysDate+1*Years;    
+        dates1[2] = Date(17, May, 2001); //todaysDate+3*Years; 
+        
+        rates[0] = 0.06;
+        rates[1] = 0.05;
+        rates[2] = 0.04;
+
+        Handle<YieldTermStructure> fowardTermStructure(
+            boost::shared_ptr<YieldTermStructure>(
+                new ForwardCurve(dates1, rates, dayCounter)));
+                
+        Handle<YieldTermStructure> fowardDividendTS(
+            boost::shared_ptr<YieldTermStructure>(
+                new ForwardCurve(dates1, rates, dayCounter)));
+
+        boost::shared_ptr<HestonProcess> hestonProcess(
+                new HestonProcess(fowardTermStructure, fowardDividendTS,
+                                  underlyingH, v0, kappa, theta, sigma, rho));
+
+        // european exercise
+        boost::shared_ptr<Exercise> europeanExercise(
+                new EuropeanExercise(maturity));
+
+        // payoff
+        boost::shared_ptr<StrikedTypePayoff> payoff(
+                new PlainVanillaPayoff(type, strike));
+        // options
+        VanillaOption europeanOption(payoff, europeanExercise);
+
+        // semi-analytic Heston
+        europeanOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                    new AnalyticHestonEngine(boost::shared_ptr<HestonModel>(
+                                            new HestonModel(hestonProcess)))));
+        clock_t t1,t2;  
+        Real res;
+
+        t1 = clock();
+        res = europeanOption.NPV();     
+        t2 = clock();
+        std::cout << "Heston(analytic) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // Monte Carlo Method: MC (crude)
+        Size timeSteps = 36;
+        Size mcSeed = 42;
+
+        boost::shared_ptr<PricingEngine> mcengine1;
+        mcengine1 = MakeMCEuropeanHestonEngine<PseudoRandom>(hestonProcess)
+            .withSteps(timeSteps)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        europeanOption.setPricingEngine(mcengine1);
+
+        t1 = clock();
+        res = europeanOption.NPV();     
+        t2 = clock();
+        std::cout << "MC (crude) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        boost::shared_ptr<PricingEngine> mcengine1c;
+        mcengine1c = MakeMCEuropeanHestonConstEngine<PseudoRandom>(hestonProcess, true)
+            .withSteps(timeSteps)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        europeanOption.setPricingEngine(mcengine1c);
+
+        t1 = clock();
+        res = europeanOption.NPV();     
+        t2 = clock();
+        std::cout << "MC const(crude) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // discrete arithmetic Asian, monthly fixings
+        std::vector<Date> fixingDates;
+        for (Integer i=1; i<=36; ++i)
+            fixingDates.push_back(todaysDate + i*Months);
+        DiscreteAveragingAsianOption asianOption(Average::Arithmetic, 0.0, 0,
+                                                 fixingDates, payoff,
+                                                 boost::shared_ptr<Exercise>(
+                                                     new EuropeanExercise(fixingDates.back())));
+
+        boost::shared_ptr<PricingEngine> mcengine2;
+        mcengine2 = MakeMCDiscreteArithmeticAPHestonConstEngine<PseudoRandom>(hestonProcess, false)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        asianOption.setPricingEngine(mcengine2);
+
+        t1 = clock();
+        res = asianOption.NPV();     
+        t2 = clock();
+        std::cout << "MC Asian (crude) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        boost::shared_ptr<PricingEngine> mcengine2c;
+        mcengine2c = MakeMCDiscreteArithmeticAPHestonConstEngine<PseudoRandom>(hestonProcess, true)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        asianOption.setPricingEngine(mcengine2c);
+
+        t1 = clock();
+        res = asianOption.NPV();     
+        t2 = clock();
+        std::cout << "MC Asian const(crude) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // End test
+        double seconds = timer.elapsed();
+        Integer hours = int(seconds/3600);
+        seconds -= hours * 3600;
+        Integer minutes = int(seconds/60);
+        seconds -= minutes * 60;
+        std::cout << " \nRun completed in ";
+        if (hours > 0)
+            std::cout << hours << " h ";
+        if (hours > 0 || minutes > 0)
+            std::cout << minutes << " m ";
+        std::cout << std::fixed << std::setprecision(0)
+                  << seconds << " s\n" << std::endl;
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+        return 1;
+    }
+}
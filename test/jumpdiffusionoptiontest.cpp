@@ -0,0 +1,178 @@
+#include <ql/quantlib.hpp>
+#include <boost/timer.hpp>
+#include <iomanip>
+#include "../src/mertonconstprocess.hpp"
+#include "../src/mcmertonconstengine.hpp"
+
+using namespace QuantLib;
+
+int main(int argc, char* argv[]){
+    
+    try{
+        
+        boost::timer timer;
+        std::cout << std::endl;
+
+        // set up dates
+        Calendar calendar = TARGET();
+        Date todaysDate(15, May, 1998);
+        Date settlementDate(17, May, 1998);
+        Settings::instance().evaluationDate() = todaysDate;
+
+        // our option parameters
+        Option::Type type(Option::Put);
+        Real underlying = 36;
+        Real strike = 40;
+        Spread dividendYield = 0.00;
+        Rate riskFreeRate = 0.06;
+        Volatility volatility = 0.20;
+
+        // jump parameters
+        Real jumpIntensity = 1.0;
+        Real logMeanJump = -0.10;
+        Real logJumpVolatility = 0.15;
+
+        Date maturity(17, May, 2001);
+
+        DayCounter dayCounter = Actual365Fixed();
+
+        std::cout << "Option type = "  << type << std::endl;
+        std::cout << "Maturity = "        << maturity << std::endl;
+        std::cout << "Underlying price = "        << underlying << std::endl;
+        std::cout << "Strike = "                  << strike << std::endl;
+        std::cout << "Risk-free interest rate = " << io::rate(riskFreeRate)
+                  << std::endl;
+        std::cout << "Dividend yield = " << io::rate(dividendYield)
+                  << std::endl;
+        std::cout << "Volatility = " << io::volatility(volatility)
+                  << std::endl;
+        std::cout << "Jump intensity = " << jumpIntensity
+                  << ", log-jump mean = " << logMeanJump
+                  << ", log-jump volatility = " << logJumpVolatility
+                  << std::endl;
+        std::cout << std::endl;
+
+
+        // underlying handler
+        Handle<Quote> underlyingH(
+                boost::shared_ptr<Quote>(new SimpleQuote(underlying)));
+
+        // bootstrap the yield/dividend/vol curves
+        Handle<YieldTermStructure> flatTermStructure(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, riskFreeRate, dayCounter)));
+        Handle<YieldTermStructure> flatDividendTS(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, dividendYield, dayCounter)));
+        Handle<BlackVolTermStructure> flatVolTS(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackConstantVol(settlementDate, calendar, volatility,
+                                     dayCounter)));
+
+        boost::shared_ptr<Merton76Process> mertonProcess(
+                new Merton76Process(underlyingH, flatDividendTS,
+                                    flatTermStructure, flatVolTS,
+                    Handle<Quote>(boost::shared_ptr<Quote>(
+                                          new SimpleQuote(jumpIntensity))),
+                    Handle<Quote>(boost::shared_ptr<Quote>(
+                                          new SimpleQuote(logMeanJump))),
+                    Handle<Quote>(boost::shared_ptr<Quote>(
+                                     new SimpleQuote(logJumpVolatility)))));
+
+        // european exercise
+        boost::shared_ptr<Exercise> europeanExercise(
+                new EuropeanExercise(maturity));
+
+        // payoff
+        boost::shared_ptr<StrikedTypePayoff> payoff(
+                new PlainVanillaPayoff(type, strike));
+        // options
+        VanillaOption europeanOption(payoff, europeanExercise);
+
+        // Merton closed form
+        europeanOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                    new JumpDiffusionEngine(mertonProcess)));
+        clock_t t1,t2;  
+        Real res;
+
+        t1 = clock();
+        res = europeanOption.NPV();     
+        t2 = clock();
+        std::cout << "Merton(analytic) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // Monte Carlo Method: MC (crude)
+        Size timeSteps = 36;
+        Size mcSeed = 42;
+
+        boost::shared_ptr<PricingEngine> mcengine1c;
+        mcengine1c = MakeMCEuropeanMertonConstEngine<PseudoRandom>(mertonProcess)
+            .withSteps(timeSteps)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        europeanOption.setPricingEngine(mcengine1c);
+
+        t1 = clock();
+        res = europeanOption.NPV();     
+        t2 = clock();
+        std::cout << "MC const(crude) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        // Monte Carlo Method: QMC (Sobol)
+        Size nSamples = 32768;  // 2^15
+
+        boost::shared_ptr<PricingEngine> mcengine2c;
+        mcengine2c = MakeMCEuropeanMertonConstEngine<LowDiscrepancy>(mertonProcess)
+            .withSteps(timeSteps)
+            .withSamples(nSamples);
+        europeanOption.setPricingEngine(mcengine2c);
+
+        t1 = clock();
+        res = europeanOption.NPV();     
+        t2 = clock();
+        std::cout << "MC const(Sobol) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // discrete arithmetic Asian, monthly fixings
+        std::vector<Date> fixingDates;
+        for (Integer i=1; i<=36; ++i)
+            fixingDates.push_back(todaysDate + i*Months);
+        DiscreteAveragingAsianOption asianOption(Average::Arithmetic, 0.0, 0,
+                                                 fixingDates, payoff,
+                                                 boost::shared_ptr<Exercise>(
+                                                     new EuropeanExercise(fixingDates.back())));
+
+        boost::shared_ptr<PricingEngine> mcengine3c;
+        mcengine3c = MakeMCDiscreteArithmeticAPMertonConstEngine<PseudoRandom>(mertonProcess)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        asianOption.setPricingEngine(mcengine3c);
+
+        t1 = clock();
+        res = asianOption.NPV();     
+        t2 = clock();
+        std::cout << "MC Asian const(crude) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // End test
+        double seconds = timer.elapsed();
+        Integer hours = int(seconds/3600);
+        seconds -= hours * 3600;
+        Integer minutes = int(seconds/60);
+        seconds -= minutes * 60;
+        std::cout << " \nRun completed in ";
+        if (hours > 0)
+            std::cout << hours << " h ";
+        if (hours > 0 || minutes > 0)
+            std::cout << minutes << " m ";
+        std::cout << std::fixed << std::setprecision(0)
+                  << seconds << " s\n" << std::endl;
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,245 @@
+#include <ql/quantlib.hpp>
+#include <boost/timer.hpp>
+#include <iomanip>
+#include "../src/blackscholesconstprocess.hpp"
+#include "../src/mclookbackconstengine.hpp"
+
+using namespace QuantLib;
+
+int main(int argc, char* argv[]){
+    
+    try{
+        
+        boost::timer timer;
+        std::cout << std::endl;
+
+        // set up dates
+        Calendar calendar = TARGET();
+        Date todaysDate(15, May, 1998);
+        Date settlementDate(17, May, 1998);
+        Settings::instance().evaluationDate() = todaysDate;
+
+        // our option parameters
+        Option::Type type(Option::Put);
+        Real underlying = 36;
+        Real strike = 40;
+        Spread dividendYield = 0.00;
+        Rate riskFreeRate = 0.06;
+        Volatility volatility = 0.20;
+
+        Date maturity(17, May, 2001);
+
+        DayCounter dayCounter = Actual365Fixed();
+
+        std::cout << "Option type = "  << type << std::endl;
+        std::cout << "Maturity = "        << maturity << std::endl;
+        std::cout << "Underlying price = "        << underlying << std::endl;
+        std::cout << "Strike = "                  << strike << std::endl;
+        std::cout << "Risk-free interest rate = " << io::rate(riskFreeRate)
+                  << std::endl;
+        std::cout << "Dividend yield = " << io::rate(dividendYield)
+                  << std::endl;
+        std::cout << "Volatility = " << io::volatility(volatility)
+                  << std::endl;
+        std::cout << std::endl;
+        std::string method;
+        std::cout << std::endl ;
+
+
+        // underlying handler
+        Handle<Quote> underlyingH(
+                boost::shared_ptr<Quote>(new SimpleQuote(underlying)));
+
+        // bootstrap the yield/dividend/vol curves
+        Handle<YieldTermStructure> flatTermStructure(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, riskFreeRate, dayCounter)));
+        Handle<YieldTermStructure> flatDividendTS(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, dividendYield, dayCounter)));
+        Handle<BlackVolTermStructure> flatVolTS(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackConstantVol(settlementDate, calendar, volatility,
+                                     dayCounter)));
+ 
+ 
+        // bootstrap the yield/dividend/vol forward curves   
+        
+        std::vector<Date> dates1(3);
+        std::vector<Rate> rates(3);
+
+        dates1[0] = Date(17, May, 1998);    
+        dates1[1] = Date(17, May, 1999); //todaysDate+1*Years;    
+        dates1[2] = Date(17, May, 2001); //todaysDate+3*Years; 
+        
+        rates[0] = 0.06;
+        rates[1] = 0.05;
+        rates[2] = 0.04;
+        
+        
+        Handle<YieldTermStructure> fowardTermStructure(
+            boost::shared_ptr<YieldTermStructure>(
+                new ForwardCurve(dates1, rates, dayCounter)));
+                
+        Handle<YieldTermStructure> fowardDividendTS(
+            boost::shared_ptr<YieldTermStructure>(
+                new ForwardCurve(dates1, rates, dayCounter)));
+                
+        std::vector<Volatility> vols(2);
+        std::vector<Date> dates2(2);
+        
+        dates2[0] = Date(17, May, 1999); //todaysDate+1*Years;    
+        dates2[1] = Date(17, May, 2001); //todaysDate+3*Years; 
+        
+        vols[0] = 0.20;
+        vols[1] = 0.25;
+        
+        Handle<BlackVolTermStructure> fowardVolTS(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackVarianceCurve(todaysDate, dates2, vols,
+                                     dayCounter)));
+        
+        // european exercise
+        boost::shared_ptr<Exercise> europeanExercise(
+                new EuropeanExercise(maturity));
+
+        // payoffs
+        boost::shared_ptr<StrikedTypePayoff> payoff(
+                new PlainVanillaPayoff(type, strike));
+        boost::shared_ptr<TypePayoff> floatingPayoff(
+                new FloatingTypePayoff(type));
+        // options
+        ContinuousFixedLookbackOption fixedLookbackOption(
+                underlying, payoff, europeanExercise);
+        ContinuousFloatingLookbackOption floatingLookbackOption(
+                underlying, floatingPayoff, europeanExercise);
+
+
+        // BlackScholes Merton Process platForward
+        boost::shared_ptr<BlackScholesMertonProcess> flatbsmProcess(
+                new BlackScholesMertonProcess(underlyingH, flatDividendTS, flatTermStructure, flatVolTS));
+
+        // BlackScholes Merton Process forward curve
+        boost::shared_ptr<BlackScholesMertonProcess> bsmProcess(
+                new BlackScholesMertonProcess(underlyingH, fowardDividendTS, fowardTermStructure, fowardVolTS));
+
+        // Analytic lookbacks (continuous monitoring) plat
+
+        fixedLookbackOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                    new AnalyticContinuousFixedLookbackEngine(flatbsmProcess)));
+        floatingLookbackOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                    new AnalyticContinuousFloatingLookbackEngine(flatbsmProcess)));
+        clock_t t1,t2;
+        Real res;
+
+        t1 = clock();
+        res = fixedLookbackOption.NPV();
+        t2 = clock();
+        std::cout << "Analytic fixed lookback(flat curve) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        t1 = clock();
+        res = floatingLookbackOption.NPV();
+        t2 = clock();
+        std::cout << "Analytic floating lookback(flat curve) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // Monte Carlo Method: MC (crude), daily monitoring on the real process
+
+        Size mcSeed = 42;
+
+        fixedLookbackOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+            MakeMCLookbackConstEngine<ContinuousFixedLookbackOption,PseudoRandom>(flatbsmProcess, false)
+                .withStepsPerYear(250)
+                .withAbsoluteTolerance(0.02)
+                .withSeed(mcSeed)));
+
+        t1 = clock();
+        res = fixedLookbackOption.NPV();
+        t2 = clock();
+        std::cout << "MC fixed lookback (250 steps/year) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        // const engine, coarse grid with exact bridge extrema
+        fixedLookbackOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+            MakeMCLookbackConstEngine<ContinuousFixedLookbackOption,PseudoRandom>(flatbsmProcess, true)
+                .withStepsPerYear(12)
+                .withAbsoluteTolerance(0.02)
+                .withSeed(mcSeed)));
+
+        t1 = clock();
+        res = fixedLookbackOption.NPV();
+        t2 = clock();
+        std::cout << "MC const fixed lookback (12 steps/year) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        floatingLookbackOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+            MakeMCLookbackConstEngine<ContinuousFloatingLookbackOption,PseudoRandom>(flatbsmProcess, false)
+                .withStepsPerYear(250)
+                .withAbsoluteTolerance(0.02)
+                .withSeed(mcSeed)));
+
+        t1 = clock();
+        res = floatingLookbackOption.NPV();
+        t2 = clock();
+        std::cout << "MC floating lookback (250 steps/year) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        floatingLookbackOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+            MakeMCLookbackConstEngine<ContinuousFloatingLookbackOption,PseudoRandom>(flatbsmProcess, true)
+                .withStepsPerYear(12)
+                .withAbsoluteTolerance(0.02)
+                .withSeed(mcSeed)));
+
+        t1 = clock();
+        res = floatingLookbackOption.NPV();
+        t2 = clock();
+        std::cout << "MC const floating lookback (12 steps/year) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // forward curves
+        floatingLookbackOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+            MakeMCLookbackConstEngine<ContinuousFloatingLookbackOption,PseudoRandom>(bsmProcess, false)
+                .withStepsPerYear(250)
+                .withAbsoluteTolerance(0.02)
+                .withSeed(mcSeed)));
+
+        t1 = clock();
+        res = floatingLookbackOption.NPV();
+        t2 = clock();
+        std::cout << "MC floating lookback (forward curve) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        floatingLookbackOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+            MakeMCLookbackConstEngine<ContinuousFloatingLookbackOption,PseudoRandom>(bsmProcess, true)
+                .withStepsPerYear(12)
+                .withAbsoluteTolerance(0.02)
+                .withSeed(mcSeed)));
+
+        t1 = clock();
+        res = floatingLookbackOption.NPV();
+        t2 = clock();
+        std::cout << "MC const floating lookback (forward curve) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+
+        // End test
+        double seconds = timer.elapsed();
+        Integer hours = int(seconds/3600);
+        seconds -= hours * 3600;
+        Integer minutes = int(seconds/60);
+        seconds -= minutes * 60;
+        std::cout << " \nRun completed in ";
+        if (hours > 0)
+            std::cout << hours << " h ";
+        if (hours > 0 || minutes > 0)
+            std::cout << minutes << " m ";
+        std::cout << std::fixed << std::setprecision(0)
+                  << seconds << " s\n" << std::endl;
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+        return 1;
+    }
+
+}
+
@@ -0,0 +1,179 @@
+#include <ql/quantlib.hpp>
+#include <boost/timer.hpp>
+#include <iomanip>
+#include <cstdio>
+#include "../src/blackscholesconstprocess.hpp"
+#include "../src/mceuropeanconstengine.hpp"
+#include "../src/marketsnapshot.hpp"
+
+using namespace QuantLib;
+
+int main(int argc, char* argv[]){
+    
+    try{
+        
+        boost::timer timer;
+        std::cout << std::endl;
+
+        // set up dates
+        Date todaysDate(15, May, 1998);
+        Settings::instance().evaluationDate() = todaysDate;
+
+        // our option parameters
+        Option::Type type(Option::Put);
+        Real underlying = 36;
+        Real strike = 40;
+
+        Date maturity(17, May, 2001);
+
+        DayCounter dayCounter = Actual365Fixed();
+
+        std::cout << "Option type = "  << type << std::endl;
+        std::cout << "Maturity = "        << maturity << std::endl;
+        std::cout << "Underlying price = "        << underlying << std::endl;
+        std::cout << "Strike = "                  << strike << std::endl;
+        std::cout << std::endl;
+
+
+        // zero/dividend/vol nodes
+        std::vector<Date> dates1(3);
+        std::vector<Rate> rates(3);
+        std::vector<Rate> dividends(3);
+
+        dates1[0] = todaysDate;
+        dates1[1] = Date(17, May, 1999);
+        dates1[2] = Date(17, May, 2001);
+
+        rates[0] = 0.06;
+        rates[1] = 0.05;
+        rates[2] = 0.04;
+
+        dividends[0] = 0.00;
+        dividends[1] = 0.01;
+        dividends[2] = 0.01;
+
+        std::vector<Volatility> vols(2);
+        std::vector<Date> dates2(2);
+
+        dates2[0] = Date(17, May, 1999);
+        dates2[1] = Date(17, May, 2001);
+
+        vols[0] = 0.20;
+        vols[1] = 0.25;
+
+        std::vector<Date> buckets(2);
+        buckets[0] = Date(17, May, 1999);
+        buckets[1] = Date(17, May, 2001);
+
+        std::string path = "marketsnapshottest.snap";
+        clock_t t1,t2;
+        Real res;
+
+        // write the snapshot
+        t1 = clock();
+        MarketSnapshotWriter writer(todaysDate);
+        writer.add("ACME", underlying, dates1, rates, dates1, dividends,
+                   dates2, vols, buckets);
+        writer.write(path);
+        t2 = clock();
+        std::cout << "Snapshot written (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        // map it back
+        t1 = clock();
+        MarketSnapshot snapshot(path);
+        Size i = snapshot.find("ACME");
+        Time T = dayCounter.yearFraction(todaysDate, maturity);
+        boost::shared_ptr<GeneralizedBlackScholesProcess> flatProcess =
+            snapshot.process(i, T);
+        t2 = clock();
+        std::cout << "Snapshot mapped (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        Rate r, q;
+        Volatility sigma;
+        snapshot.frozen(i, T, r, q, sigma);
+        std::cout << "Frozen r = " << io::rate(r)
+                  << ", q = " << io::rate(q)
+                  << ", sigma = " << io::volatility(sigma) << std::endl;
+        std::cout << std::endl;
+
+        // european option
+        boost::shared_ptr<Exercise> europeanExercise(
+                new EuropeanExercise(maturity));
+        boost::shared_ptr<StrikedTypePayoff> payoff(
+                new PlainVanillaPayoff(type, strike));
+        VanillaOption europeanOption(payoff, europeanExercise);
+
+        // reference: full curves rebuilt from the snapshot nodes
+        boost::shared_ptr<BlackScholesMertonProcess> bsmProcess(
+                new BlackScholesMertonProcess(
+                    Handle<Quote>(boost::shared_ptr<Quote>(
+                                    new SimpleQuote(snapshot.spot(i)))),
+                    snapshot.dividendCurve(i),
+                    snapshot.riskFreeCurve(i),
+                    snapshot.volatilityCurve(i)));
+
+        europeanOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                    new AnalyticEuropeanEngine(bsmProcess)));
+        res = europeanOption.NPV();
+        std::cout << "Black-Scholes(snapshot curves) : " << res << std::endl;
+
+        europeanOption.setPricingEngine(boost::shared_ptr<PricingEngine>(
+                    new AnalyticEuropeanEngine(flatProcess)));
+        res = europeanOption.NPV();
+        std::cout << "Black-Scholes(snapshot frozen) : " << res << std::endl;
+
+
+        // Monte Carlo Method: MC (crude)
+        Size timeSteps = 1;
+        Size mcSeed = 42;
+
+        boost::shared_ptr<PricingEngine> mcengine1c;
+        mcengine1c = MakeMCEuropeanConstEngine<PseudoRandom>(bsmProcess, true)
+            .withSteps(timeSteps)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        europeanOption.setPricingEngine(mcengine1c);
+
+        t1 = clock();
+        res = europeanOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(snapshot curves) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        boost::shared_ptr<PricingEngine> mcengine2c;
+        mcengine2c = MakeMCEuropeanConstEngine<PseudoRandom>(flatProcess, true)
+            .withSteps(timeSteps)
+            .withAbsoluteTolerance(0.02)
+            .withSeed(mcSeed);
+        europeanOption.setPricingEngine(mcengine2c);
+
+        t1 = clock();
+        res = europeanOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(snapshot frozen) : " << res << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        std::remove(path.c_str());
+
+
+        // End test
+        double seconds = timer.elapsed();
+        Integer hours = int(seconds/3600);
+        seconds -= hours * 3600;
+        Integer minutes = int(seconds/60);
+        seconds -= minutes * 60;
+        std::cout << " \nRun completed in ";
+        if (hours > 0)
+            std::cout << hours << " h ";
+        if (hours > 0 || minutes > 0)
+            std::cout << minutes << " m ";
+        std::cout << std::fixed << std::setprecision(0)
+                  << seconds << " s\n" << std::endl;
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+        return 1;
+    }
+}
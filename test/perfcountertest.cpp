@@ -0,0 +1,241 @@
+#include <ql/quantlib.hpp>
+#include <boost/timer.hpp>
+#include <iomanip>
+#include "../src/blackscholesconstprocess.hpp"
+#include "../src/mceuropeanconstengine.hpp"
+#include "../src/mc_discr_arith_av_price_const.hpp"
+#include "../src/perfcounters.hpp"
+
+using namespace QuantLib;
+
+// engines with their simulation phases made callable
+class ProfiledEuropeanEngine
+    : public MCEuropeanConstEngine<PseudoRandom> {
+  public:
+    ProfiledEuropeanEngine(
+             const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+             Size timeSteps, Size samples, BigNatural seed, bool ifconst)
+    : MCEuropeanConstEngine<PseudoRandom>(process, timeSteps, Null<Size>(),
+                                          false, false, samples,
+                                          Null<Real>(), Null<Size>(),
+                                          seed, ifconst) {}
+    using MCEuropeanConstEngine<PseudoRandom>::pathGenerator;
+    using MCEuropeanConstEngine<PseudoRandom>::pathPricer;
+    using MCEuropeanConstEngine<PseudoRandom>::timeGrid;
+};
+
+class ProfiledAsianEngine
+    : public MCDiscreteArithmeticAPConstEngine<PseudoRandom> {
+  public:
+    ProfiledAsianEngine(
+             const boost::shared_ptr<GeneralizedBlackScholesProcess>& process,
+             Size samples, BigNatural seed, bool ifconst)
+    : MCDiscreteArithmeticAPConstEngine<PseudoRandom>(process, false, false,
+                                                      false, samples,
+                                                      Null<Real>(),
+                                                      Null<Size>(),
+                                                      seed, ifconst) {}
+    using MCDiscreteArithmeticAPConstEngine<PseudoRandom>::pathGenerator;
+    using MCDiscreteArithmeticAPConstEngine<PseudoRandom>::pathPricer;
+    using MCDiscreteArithmeticAPConstEngine<PseudoRandom>::timeGrid;
+};
+
+void report(const std::string& phase, const PerfSample& s,
+            double paths, double steps) {
+    std::cout << "  " << std::left << std::setw(13) << phase << std::right
+              << std::fixed << std::setprecision(2)
+              << std::setw(10) << s.seconds*1000.0 << "ms";
+    Real v[] = { s.per(PerfSample::Cycles, paths),
+                 s.per(PerfSample::Cycles, steps),
+                 s.ipc(),
+                 s.per(PerfSample::CacheMisses, paths),
+                 s.per(PerfSample::BranchMisses, paths) };
+    for (Size i=0; i<sizeof(v)/sizeof(v[0]); ++i) {
+        if (v[i] == Null<Real>())
+            std::cout << std::setw(12) << "n/a";
+        else
+            std::cout << std::setw(12) << v[i];
+    }
+    std::cout << std::endl;
+}
+
+/* Phases: the whole NPV; building the path generator and pricer;
+   drawing the paths alone; drawing and pricing them again, the
+   payoff being the difference of the last two. */
+template <class Engine>
+void profile(const std::string& name,
+             Instrument& option,
+             const boost::shared_ptr<Engine>& engine,
+             Size samples,
+             PerfCounters& counters) {
+    typedef typename Engine::path_generator_type path_generator_type;
+    typedef typename Engine::path_pricer_type path_pricer_type;
+
+    option.setPricingEngine(engine);
+    counters.start();
+    Real npv = option.NPV();
+    PerfSample total = counters.stop();
+
+    Size steps = engine->timeGrid().size()-1;
+    double paths = double(samples), nodes = double(samples*steps);
+
+    counters.start();
+    boost::shared_ptr<path_generator_type> generator =
+        engine->pathGenerator();
+    boost::shared_ptr<path_pricer_type> pricer = engine->pathPricer();
+    PerfSample setup = counters.stop();
+
+    counters.start();
+    for (Size i=0; i<samples; ++i)
+        generator->next();
+    PerfSample drawing = counters.stop();
+
+    generator = engine->pathGenerator();
+    Real sum = 0.0;
+    counters.start();
+    for (Size i=0; i<samples; ++i)
+        sum += (*pricer)(generator->next().value);
+    PerfSample pricing = counters.stop();
+
+    PerfSample payoff = pricing;
+    payoff.seconds -= drawing.seconds;
+    for (Size i=0; i<PerfSample::Events; ++i) {
+        payoff.count[i] -= drawing.count[i];
+        payoff.counted[i] = payoff.counted[i] && drawing.counted[i];
+    }
+
+    std::cout << name << " : " << npv << " (" << steps << " steps, "
+              << sum/samples << " from the phases)" << std::endl;
+    std::cout << "  " << std::left << std::setw(13) << "phase" << std::right
+              << std::setw(12) << "time"
+              << std::setw(12) << "cyc/path" << std::setw(12) << "cyc/step"
+              << std::setw(12) << "IPC" << std::setw(12) << "miss/path"
+              << std::setw(12) << "brmiss/path" << std::endl;
+    report("NPV", total, paths, nodes);
+    report("setup", setup, paths, nodes);
+    report("paths", drawing, paths, nodes);
+    report("paths+payoff", pricing, paths, nodes);
+    report("payoff", payoff, paths, nodes);
+    std::cout << std::setprecision(6);
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+int main(int argc, char* argv[]){
+    
+    try{
+        
+        boost::timer timer;
+        std::cout << std::endl;
+
+        // set up dates
+        Calendar calendar = TARGET();
+        Date todaysDate(15, May, 1998);
+        Date settlementDate(17, May, 1998);
+        Settings::instance().evaluationDate() = todaysDate;
+
+        // our option parameters
+        Option::Type type(Option::Put);
+        Real underlying = 36;
+        Real strike = 40;
+        Spread dividendYield = 0.00;
+        Rate riskFreeRate = 0.06;
+        Volatility volatility = 0.20;
+
+        Date maturity(17, May, 2001);
+
+        DayCounter dayCounter = Actual365Fixed();
+
+        std::cout << "Option type = "  << type << std::endl;
+        std::cout << "Maturity = "        << maturity << std::endl;
+        std::cout << "Underlying price = "        << underlying << std::endl;
+        std::cout << "Strike = "                  << strike << std::endl;
+        std::cout << std::endl;
+
+
+        // underlying handler
+        Handle<Quote> underlyingH(
+                boost::shared_ptr<Quote>(new SimpleQuote(underlying)));
+
+        // bootstrap the yield/dividend/vol curves
+        Handle<YieldTermStructure> flatTermStructure(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, riskFreeRate, dayCounter)));
+        Handle<YieldTermStructure> flatDividendTS(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, dividendYield, dayCounter)));
+        Handle<BlackVolTermStructure> flatVolTS(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackConstantVol(settlementDate, calendar, volatility,
+                                     dayCounter)));
+
+        boost::shared_ptr<BlackScholesMertonProcess> bsmProcess(
+                new BlackScholesMertonProcess(underlyingH, flatDividendTS, flatTermStructure, flatVolTS));
+
+        // options
+        boost::shared_ptr<Exercise> europeanExercise(
+                new EuropeanExercise(maturity));
+        boost::shared_ptr<StrikedTypePayoff> payoff(
+                new PlainVanillaPayoff(type, strike));
+        VanillaOption europeanOption(payoff, europeanExercise);
+
+        std::vector<Date> fixingDates;
+        for (Integer i=1; i<=36; ++i)
+            fixingDates.push_back(todaysDate + i*Months);
+        DiscreteAveragingAsianOption asianOption(Average::Arithmetic, 0.0, 0,
+                                                 fixingDates, payoff,
+                                                 boost::shared_ptr<Exercise>(
+                                                     new EuropeanExercise(fixingDates.back())));
+
+        PerfCounters counters;
+        std::cout << "hardware counters : " << counters.status() << std::endl;
+        std::cout << std::endl;
+
+        BigNatural mcSeed = 42;
+        Size timeSteps = 36;
+        Size nSamples = 1 << 16;
+
+        profile("MC (European)", europeanOption,
+                boost::shared_ptr<ProfiledEuropeanEngine>(
+                    new ProfiledEuropeanEngine(bsmProcess, timeSteps,
+                                               nSamples, mcSeed, false)),
+                nSamples, counters);
+        profile("MC const(European)", europeanOption,
+                boost::shared_ptr<ProfiledEuropeanEngine>(
+                    new ProfiledEuropeanEngine(bsmProcess, timeSteps,
+                                               nSamples, mcSeed, true)),
+                nSamples, counters);
+        profile("MC (Asian)", asianOption,
+                boost::shared_ptr<ProfiledAsianEngine>(
+                    new ProfiledAsianEngine(bsmProcess, nSamples,
+                                            mcSeed, false)),
+                nSamples, counters);
+        profile("MC const(Asian)", asianOption,
+                boost::shared_ptr<ProfiledAsianEngine>(
+                    new ProfiledAsianEngine(bsmProcess, nSamples,
+                                            mcSeed, true)),
+                nSamples, counters);
+
+
+        // End test
+        double seconds = timer.elapsed();
+        Integer hours = int(seconds/3600);
+        seconds -= hours * 3600;
+        Integer minutes = int(seconds/60);
+        seconds -= minutes * 60;
+        std::cout << " \nRun completed in ";
+        if (hours > 0)
+            std::cout << hours << " h ";
+        if (hours > 0 || minutes > 0)
+            std::cout << minutes << " m ";
+        std::cout << std::fixed << std::setprecision(0)
+                  << seconds << " s\n" << std::endl;
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+        return 1;
+    }
+}
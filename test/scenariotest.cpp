@@ -0,0 +1,144 @@
+#include <ql/quantlib.hpp>
+#include <boost/timer.hpp>
+#include <iomanip>
+#include "../src/blackscholesconstprocess.hpp"
+#include "../src/mcconstscenarioengine.hpp"
+
+using namespace QuantLib;
+
+int main(int argc, char* argv[]){
+    
+    try{
+        
+        boost::timer timer;
+        std::cout << std::endl;
+
+        // set up dates
+        Calendar calendar = TARGET();
+        Date todaysDate(15, May, 1998);
+        Date settlementDate(17, May, 1998);
+        Settings::instance().evaluationDate() = todaysDate;
+
+        // our option parameters
+        Option::Type type(Option::Put);
+        Real underlying = 36;
+        Real strike = 40;
+        Spread dividendYield = 0.00;
+        Rate riskFreeRate = 0.06;
+        Volatility volatility = 0.20;
+
+        Date maturity(17, May, 2001);
+
+        DayCounter dayCounter = Actual365Fixed();
+
+        std::cout << "Option type = "  << type << std::endl;
+        std::cout << "Maturity = "        << maturity << std::endl;
+        std::cout << "Underlying price = "        << underlying << std::endl;
+        std::cout << "Strike = "                  << strike << std::endl;
+        std::cout << std::endl;
+
+
+        // underlying handler
+        Handle<Quote> underlyingH(
+                boost::shared_ptr<Quote>(new SimpleQuote(underlying)));
+
+        // bootstrap the yield/dividend/vol curves
+        Handle<YieldTermStructure> flatTermStructure(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, riskFreeRate, dayCounter)));
+        Handle<YieldTermStructure> flatDividendTS(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, dividendYield, dayCounter)));
+        Handle<BlackVolTermStructure> flatVolTS(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackConstantVol(settlementDate, calendar, volatility,
+                                     dayCounter)));
+
+        boost::shared_ptr<BlackScholesMertonProcess> bsmProcess(
+                new BlackScholesMertonProcess(underlyingH, flatDividendTS, flatTermStructure, flatVolTS));
+
+        boost::shared_ptr<StrikedTypePayoff> payoff(
+                new PlainVanillaPayoff(type, strike));
+
+        // base scenario first, then a 10x10 spot/vol shock grid
+        ConstScenario base = ConstScenario::frozen(bsmProcess, maturity);
+        std::vector<ConstScenario> scenarios(1, base);
+        for (Integer i=-5; i<5; ++i)
+            for (Integer j=-5; j<5; ++j)
+                scenarios.push_back(base.shocked(0.02*i, 0.01*j, 0.0));
+        std::vector<ConstScenario> single(1, base);
+
+        Time T = bsmProcess->time(maturity);
+        std::vector<Time> fixingTimes;
+        for (Integer i=1; i<=36; ++i)
+            fixingTimes.push_back(bsmProcess->time(todaysDate + i*Months));
+
+        BigNatural mcSeed = 42;
+        Size nSamples = 1 << 18;
+        clock_t t1,t2;  
+        std::vector<ScenarioResult> res;
+
+        MCConstScenarioEngine<PseudoRandom> engine(nSamples, mcSeed, true);
+
+        t1 = clock();
+        res = engine.europeanValues(payoff, T, single);
+        t2 = clock();
+        std::cout << "MC scenarios(European, 1 scenario) : " << res[0].value << " +/- " << res[0].errorEstimate << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        t1 = clock();
+        res = engine.europeanValues(payoff, T, scenarios);
+        t2 = clock();
+        std::cout << "MC scenarios(European, " << scenarios.size() << " scenarios) : " << res[0].value << " +/- " << res[0].errorEstimate << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        // spot shocks at base vol against Black-Scholes
+        for (Size k=6; k<=96; k+=10) {
+            const ConstScenario& s = scenarios[k];
+            Real df = std::exp(-s.riskFreeForward*T);
+            Real forward = s.spot*std::exp((s.riskFreeForward-s.dividendForward)*T);
+            Real bs = blackFormula(type, strike, forward,
+                                   s.volatility*std::sqrt(T), df);
+            std::cout << "  S0 " << std::setw(6) << s.spot
+                      << " vol " << std::setw(5) << s.volatility
+                      << " : " << res[k].value << " (BS " << bs << ")"
+                      << "  P&L " << res[k].pnl << " +/- " << res[k].pnlErrorEstimate
+                      << " vs " << res[k].errorEstimate << " independent" << std::endl;
+        }
+
+        MCConstScenarioEngine<PseudoRandom> asianEngine(nSamples/16, mcSeed, false, true);
+
+        t1 = clock();
+        res = asianEngine.arithmeticAsianValues(payoff, fixingTimes, single);
+        t2 = clock();
+        std::cout << "MC scenarios(Asian, 1 scenario) : " << res[0].value << " +/- " << res[0].errorEstimate << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        t1 = clock();
+        res = asianEngine.arithmeticAsianValues(payoff, fixingTimes, scenarios);
+        t2 = clock();
+        std::cout << "MC scenarios(Asian, " << scenarios.size() << " scenarios) : " << res[0].value << " +/- " << res[0].errorEstimate << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+        std::cout << "  S0 " << scenarios[100].spot << " vol " << scenarios[100].volatility
+                  << " P&L " << res[100].pnl << " +/- " << res[100].pnlErrorEstimate << std::endl;
+
+
+        // End test
+        double seconds = timer.elapsed();
+        Integer hours = int(seconds/3600);
+        seconds -= hours * 3600;
+        Integer minutes = int(seconds/60);
+        seconds -= minutes * 60;
+        std::cout << " \nRun completed in ";
+        if (hours > 0)
+            std::cout << hours << " h ";
+        if (hours > 0 || minutes > 0)
+            std::cout << minutes << " m ";
+        std::cout << std::fixed << std::setprecision(0)
+                  << seconds << " s\n" << std::endl;
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,219 @@
+#include <ql/quantlib.hpp>
+#include <boost/timer.hpp>
+#include <iomanip>
+#include "../src/blackscholesconstprocess.hpp"
+#include "../src/mceuropeanconstengine.hpp"
+#include "../src/mc_discr_arith_av_price_const.hpp"
+#include "../src/shardedsimulation.hpp"
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+using namespace QuantLib;
+
+typedef MCEuropeanConstEngine<PseudoRandom> EuropeanEngine;
+typedef MCEuropeanConstEngine<LowDiscrepancy> SobolEuropeanEngine;
+typedef MCDiscreteArithmeticAPConstEngine<PseudoRandom> AsianEngine;
+
+// engine factories: one engine per worker
+template <class Engine>
+struct EuropeanFactory {
+    boost::shared_ptr<GeneralizedBlackScholesProcess> process;
+    Size steps;
+    boost::shared_ptr<Engine> operator()(BigNatural seed,
+                                         Size samples) const {
+        return boost::shared_ptr<Engine>(
+            new Engine(process, steps, Null<Size>(), false, false,
+                       samples, Null<Real>(), Null<Size>(),
+                       seed, true));
+    }
+};
+
+// wall-clock milliseconds; clock() only sees the coordinator
+double wallTime() {
+    using namespace boost::posix_time;
+    static const ptime start = microsec_clock::universal_time();
+    return (microsec_clock::universal_time()-start).total_microseconds()
+           / 1000.0;
+}
+
+struct AsianFactory {
+    boost::shared_ptr<GeneralizedBlackScholesProcess> process;
+    boost::shared_ptr<AsianEngine> operator()(BigNatural seed,
+                                              Size samples) const {
+        return boost::shared_ptr<AsianEngine>(
+            new AsianEngine(process, true, false, false,
+                            samples, Null<Real>(), Null<Size>(),
+                            seed, true));
+    }
+};
+
+int main(int argc, char* argv[]){
+    
+    try{
+        
+        boost::timer timer;
+        std::cout << std::endl;
+
+        // set up dates
+        Calendar calendar = TARGET();
+        Date todaysDate(15, May, 1998);
+        Date settlementDate(17, May, 1998);
+        Settings::instance().evaluationDate() = todaysDate;
+
+        // our option parameters
+        Option::Type type(Option::Put);
+        Real underlying = 36;
+        Real strike = 40;
+        Spread dividendYield = 0.00;
+        Rate riskFreeRate = 0.06;
+        Volatility volatility = 0.20;
+
+        Date maturity(17, May, 2001);
+
+        DayCounter dayCounter = Actual365Fixed();
+
+        std::cout << "Option type = "  << type << std::endl;
+        std::cout << "Maturity = "        << maturity << std::endl;
+        std::cout << "Underlying price = "        << underlying << std::endl;
+        std::cout << "Strike = "                  << strike << std::endl;
+        std::cout << std::endl;
+
+
+        // underlying handler
+        Handle<Quote> underlyingH(
+                boost::shared_ptr<Quote>(new SimpleQuote(underlying)));
+
+        // bootstrap the yield/dividend/vol curves
+        Handle<YieldTermStructure> flatTermStructure(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, riskFreeRate, dayCounter)));
+        Handle<YieldTermStructure> flatDividendTS(
+            boost::shared_ptr<YieldTermStructure>(
+                new FlatForward(settlementDate, dividendYield, dayCounter)));
+        Handle<BlackVolTermStructure> flatVolTS(
+            boost::shared_ptr<BlackVolTermStructure>(
+                new BlackConstantVol(settlementDate, calendar, volatility,
+                                     dayCounter)));
+
+        boost::shared_ptr<BlackScholesMertonProcess> bsmProcess(
+                new BlackScholesMertonProcess(underlyingH, flatDividendTS, flatTermStructure, flatVolTS));
+
+        // options
+        boost::shared_ptr<Exercise> europeanExercise(
+                new EuropeanExercise(maturity));
+        boost::shared_ptr<StrikedTypePayoff> payoff(
+                new PlainVanillaPayoff(type, strike));
+        VanillaOption europeanOption(payoff, europeanExercise);
+
+        std::vector<Date> fixingDates;
+        for (Integer i=1; i<=36; ++i)
+            fixingDates.push_back(todaysDate + i*Months);
+        DiscreteAveragingAsianOption asianOption(Average::Arithmetic, 0.0, 0,
+                                                 fixingDates, payoff,
+                                                 boost::shared_ptr<Exercise>(
+                                                     new EuropeanExercise(fixingDates.back())));
+
+        BigNatural mcSeed = 42;
+        Size nSamples = 1 << 20;
+        Size nShards = 64;
+        Size nWorkers = 4;
+        clock_t t1,t2;  
+        double w1,w2;
+        ShardAccumulator res;
+
+        EuropeanFactory<EuropeanEngine> europeanFactory;
+        europeanFactory.process = bsmProcess;
+        europeanFactory.steps = 1;
+        ShardedSimulation<EuropeanEngine> european(
+            europeanOption, europeanFactory, mcSeed, nSamples, nShards);
+
+        // the instrument keeps its own engine while it is sharded
+        europeanOption.setPricingEngine(europeanFactory(mcSeed, nSamples));
+        t1 = clock();
+        Real plain = europeanOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(European, plain engine) : " << plain << " +/- " << europeanOption.errorEstimate() << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        w1 = wallTime();
+        res = european.run(1);
+        w2 = wallTime();
+        double singleTime = w2-w1;
+        std::cout << "MC const(European, 1 process) : " << res.mean << " +/- " << res.errorEstimate() << " (" << singleTime << "ms wall)"<<std::endl;
+        std::cout << "same as plain engine : " << (std::fabs(res.mean-plain) <= 1.0e-10*std::fabs(plain) ? "yes" : "no") << std::endl;
+        std::cout << "instrument engine kept : " << (europeanOption.NPV() == plain ? "yes" : "no") << std::endl;
+        Real single = res.mean;
+
+        w1 = wallTime();
+        res = european.run(nWorkers);
+        w2 = wallTime();
+        std::cout << "MC const(European, " << nWorkers << " processes) : " << res.mean << " +/- " << res.errorEstimate() << " (" << w2-w1 << "ms wall)"<<std::endl;
+        std::cout << "identical : " << (res.mean == single ? "yes" : "no") << std::endl;
+        std::cout << "speedup : " << singleTime/(w2-w1) << std::endl;
+
+        // Sobol shards are positioned with skipTo()
+        EuropeanFactory<SobolEuropeanEngine> sobolFactory;
+        sobolFactory.process = bsmProcess;
+        sobolFactory.steps = 1;
+        ShardedSimulation<SobolEuropeanEngine> sobol(
+            europeanOption, sobolFactory, mcSeed, nSamples, nShards);
+
+        VanillaOption sobolOption(payoff, europeanExercise);
+        sobolOption.setPricingEngine(sobolFactory(mcSeed, nSamples));
+        plain = sobolOption.NPV();
+        std::cout << "MC const(European Sobol, plain engine) : " << plain << std::endl;
+
+        w1 = wallTime();
+        res = sobol.run(nWorkers);
+        w2 = wallTime();
+        std::cout << "MC const(European Sobol, " << nWorkers << " processes) : " << res.mean << " (" << w2-w1 << "ms wall)"<<std::endl;
+        std::cout << "same as plain engine : " << (std::fabs(res.mean-plain) <= 1.0e-10*std::fabs(plain) ? "yes" : "no") << std::endl;
+
+        AsianFactory asianFactory;
+        asianFactory.process = bsmProcess;
+        ShardedSimulation<AsianEngine> asian(
+            asianOption, asianFactory, mcSeed, nSamples/16, nShards);
+
+        asianOption.setPricingEngine(asianFactory(mcSeed, nSamples/16));
+        t1 = clock();
+        plain = asianOption.NPV();
+        t2 = clock();
+        std::cout << "MC const(Asian, plain engine) : " << plain << " +/- " << asianOption.errorEstimate() << " (" << (float)(t2-t1)/(double(CLOCKS_PER_SEC)*1000) << "ms)"<<std::endl;
+
+        w1 = wallTime();
+        res = asian.run(1);
+        w2 = wallTime();
+        singleTime = w2-w1;
+        std::cout << "MC const(Asian, 1 process) : " << res.mean << " +/- " << res.errorEstimate() << " (" << singleTime << "ms wall)"<<std::endl;
+        std::cout << "same as plain engine : " << (std::fabs(res.mean-plain) <= 1.0e-10*std::fabs(plain) ? "yes" : "no") << std::endl;
+        single = res.mean;
+
+        w1 = wallTime();
+        res = asian.run(nWorkers);
+        w2 = wallTime();
+        std::cout << "MC const(Asian, " << nWorkers << " processes) : " << res.mean << " +/- " << res.errorEstimate() << " (" << w2-w1 << "ms wall)"<<std::endl;
+        std::cout << "identical : " << (res.mean == single ? "yes" : "no") << std::endl;
+        std::cout << "speedup : " << singleTime/(w2-w1) << std::endl;
+
+
+        // End test
+        double seconds = timer.elapsed();
+        Integer hours = int(seconds/3600);
+        seconds -= hours * 3600;
+        Integer minutes = int(seconds/60);
+        seconds -= minutes * 60;
+        std::cout << " \nRun completed in ";
+        if (hours > 0)
+            std::cout << hours << " h ";
+        if (hours > 0 || minutes > 0)
+            std::cout << minutes << " m ";
+        std::cout << std::fixed << std::setprecision(0)
+                  << seconds << " s\n" << std::endl;
+        return 0;
+
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "unknown error" << std::endl;
+        return 1;
+    }
+}